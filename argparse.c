@@ -25,60 +25,125 @@
  * SOFTWARE.
  */
 
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
 #include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "argparse.h"
 
+extern char **environ;
+
 /********************* ERROR MACROS *********************/
 
 #define ARGPARSE_NO_ERROR()                                                    \
-    ((argparse_error_t){ARGPARSE_NO_ERROR, NULL, NULL, 0})
+    ((argparse_error_t){ARGPARSE_NO_ERROR, NULL, NULL, 0, NULL, 0, 0})
 
 #define ARGPARSE_INVALID_FLAG_OR_NAME_ERROR(msg, name)                         \
-    ((argparse_error_t){ARGPARSE_INVALID_FLAG_OR_NAME_ERROR, (msg), (name), 0})
+    ((argparse_error_t){ARGPARSE_INVALID_FLAG_OR_NAME_ERROR, (msg), (name),    \
+                        0, NULL, 0, 0})
 
 #define ARGPARSE_INVALID_TYPE_ERROR(type)                                      \
-    ((argparse_error_t){ARGPARSE_INVALID_TYPE_ERROR, NULL, NULL, (type)})
+    ((argparse_error_t){ARGPARSE_INVALID_TYPE_ERROR, NULL, NULL, (type),       \
+                        NULL, 0, 0})
 
 #define ARGPARSE_INVALID_ACTION_ERROR(action)                                  \
-    ((argparse_error_t){ARGPARSE_INVALID_ACTION_ERROR, NULL, NULL, (action)})
+    ((argparse_error_t){ARGPARSE_INVALID_ACTION_ERROR, NULL, NULL, (action),   \
+                        NULL, 0, 0})
 
 #define ARGPARSE_UNSUPPORTED_CHOICES_ERROR(name, flag)                         \
     ((argparse_error_t){ARGPARSE_UNSUPPORTED_CHOICES_ERROR, NULL, (name),      \
-                        (flag)})
+                        (flag), NULL, 0, 0})
 
 #define ARGPARSE_UNSUPPORTED_ACTION_ERROR(msg, name, flag)                     \
     ((argparse_error_t){ARGPARSE_UNSUPPORTED_ACTION_ERROR, (msg), (name),      \
-                        (flag)})
+                        (flag), NULL, 0, 0})
 
 #define ARGPARSE_CONFLICTING_OPTIONS_ERROR(msg, name, flag)                    \
     ((argparse_error_t){ARGPARSE_CONFLICTING_OPTIONS_ERROR, (msg), (name),     \
-                        (flag)})
+                        (flag), NULL, 0, 0})
 
 #define ARGPARSE_UNSUPPORTED_REQUIRE_ERROR(name, flag)                         \
     ((argparse_error_t){ARGPARSE_UNSUPPORTED_REQUIRE_ERROR, NULL, (name),      \
-                        (flag)})
+                        (flag), NULL, 0, 0})
 
 #define ARGPARSE_ARGUMENT_UNKNOWN_ERROR(name)                                  \
-    ((argparse_error_t){ARGPARSE_ARGUMENT_UNKNOWN_ERROR, NULL, (name), 0})
+    ((argparse_error_t){ARGPARSE_ARGUMENT_UNKNOWN_ERROR, NULL, (name), 0,      \
+                        NULL, 0, 0})
 
 #define ARGPARSE_INT_RANGE_EXCEEDED_ERROR(msg, name, flag)                     \
     ((argparse_error_t){ARGPARSE_INT_RANGE_EXCEEDED_ERROR, (msg), (name),      \
-                        (flag)})
+                        (flag), NULL, 0, 0})
 
 #define ARGPARSE_ARGUMENT_MISSING_VALUE_ERROR(name, flag)                      \
     ((argparse_error_t){ARGPARSE_ARGUMENT_MISSING_VALUE_ERROR, NULL, (name),   \
-                        (flag)})
+                        (flag), NULL, 0, 0})
 
 #define ARGPARSE_INVALID_CHOICE_ERROR(name, flag)                              \
-    ((argparse_error_t){ARGPARSE_INVALID_CHOICE_ERROR, NULL, (name), (flag)})
+    ((argparse_error_t){ARGPARSE_INVALID_CHOICE_ERROR, NULL, (name), (flag),   \
+                        NULL, 0, 0})
 
 #define ARGPARSE_MISSING_ARGUMENT_ERROR(name, flag)                            \
-    ((argparse_error_t){ARGPARSE_MISSING_ARGUMENT_ERROR, NULL, (name), (flag)})
+    ((argparse_error_t){ARGPARSE_MISSING_ARGUMENT_ERROR, NULL, (name),         \
+                        (flag), NULL, 0, 0})
+
+#define ARGPARSE_INVALID_JSON_ERROR(msg, name)                                 \
+    ((argparse_error_t){ARGPARSE_INVALID_JSON_ERROR, (msg), (name), 0,         \
+                        NULL, 0, 0})
+
+#define ARGPARSE_FILE_ERROR(msg, name)                                         \
+    ((argparse_error_t){ARGPARSE_FILE_ERROR, (msg), (name), 0, NULL, 0, 0})
+
+#define ARGPARSE_INVALID_CONFIG_ERROR(msg, name)                               \
+    ((argparse_error_t){ARGPARSE_INVALID_CONFIG_ERROR, (msg), (name), 0,       \
+                        NULL, 0, 0})
+
+#define ARGPARSE_OUT_OF_MEMORY_ERROR(msg, name)                                \
+    ((argparse_error_t){ARGPARSE_OUT_OF_MEMORY_ERROR, (msg), (name), 0, NULL,  \
+                        0, 0})
+
+#define ARGPARSE_INVALID_FIELD_ERROR(msg, name, flag)                          \
+    ((argparse_error_t){ARGPARSE_INVALID_FIELD_ERROR, (msg), (name), (flag),   \
+                        NULL, 0, 0})
+
+#define ARGPARSE_CAPACITY_EXCEEDED_ERROR(msg, name)                            \
+    ((argparse_error_t){ARGPARSE_CAPACITY_EXCEEDED_ERROR, (msg), (name), 0,    \
+                        NULL, 0, 0})
+
+#define ARGPARSE_DUPLICATE_KEY_ERROR(msg, name)                                \
+    ((argparse_error_t){ARGPARSE_DUPLICATE_KEY_ERROR, (msg), (name), 0, NULL,  \
+                        0, 0})
+
+#define ARGPARSE_TYPE_MISMATCH_ERROR(msg, name)                                \
+    ((argparse_error_t){ARGPARSE_TYPE_MISMATCH_ERROR, (msg), (name), 0, NULL,  \
+                        0, 0})
+
+#define ARGPARSE_CALLBACK_ERROR(msg, name, status)                             \
+    ((argparse_error_t){ARGPARSE_CALLBACK_ERROR, (msg), (name), 0, NULL, 0,    \
+                        (status)})
+
+#define ARGPARSE_UNEXPECTED_VALUE_ERROR(msg, name)                             \
+    ((argparse_error_t){ARGPARSE_UNEXPECTED_VALUE_ERROR, (msg), (name), 0,     \
+                        NULL, 0, 0})
+
+#define ARGPARSE_OUT_OF_BOUNDS_ERROR(msg, name, flag)                          \
+    ((argparse_error_t){ARGPARSE_OUT_OF_BOUNDS_ERROR, (msg), (name), (flag),   \
+                        NULL, 0, 0})
+
+#define ARGPARSE_INVALID_VALUE_ERROR(msg, name, flag)                          \
+    ((argparse_error_t){ARGPARSE_INVALID_VALUE_ERROR, (msg), (name), (flag),   \
+                        NULL, 0, 0})
 
 /*
  * Returns the error code and exits from the function if non-zero error code
@@ -112,6 +177,116 @@
 #define WITHIN(val, tar)                                                       \
     ((val) >= (tar) - EPSILON_FLOAT && (val) <= (tar) + EPSILON_FLOAT)
 
+/*
+ * Checks if `arg` takes a value from the argument following it
+ */
+#define TAKES_VALUE(arg)                                                       \
+    ((arg)->action_ == ARGPARSE_STORE_ACTION ||                                \
+     (arg)->action_ == ARGPARSE_APPEND_ACTION ||                               \
+     (arg)->action_ == ARGPARSE_CALLBACK_ACTION)
+
+/*
+ * Checks if the values of `arg` are stored in an array, because it takes
+ * several values, a list or repeated occurrences
+ */
+#define IS_ARRAY(arg)                                                          \
+    ((arg)->nargs_ || (arg)->delimiter_ ||                                     \
+     (arg)->action_ == ARGPARSE_APPEND_ACTION)
+
+/*
+ * Checks if the value of `arg` is bound without conversion, because the parser
+ * is in lazy mode and the argument stores a single value
+ */
+#define IS_LAZY(parser, arg)                                                   \
+    ((parser)->lazy_ && (arg)->action_ == ARGPARSE_STORE_ACTION &&             \
+     !IS_ARRAY(arg) && (arg)->type_ != ARGPARSE_DICT_TYPE)
+
+/*
+ * Checks if the type `type` is one of the integer types converted with 64-bit
+ * overflow checks
+ */
+#define IS_WIDE_INT(type)                                                      \
+    ((type) == ARGPARSE_INT64_TYPE || (type) == ARGPARSE_UINT32_TYPE ||        \
+     (type) == ARGPARSE_UINT64_TYPE || (type) == ARGPARSE_SIZE_TYPE ||         \
+     (type) == ARGPARSE_DURATION_TYPE)
+
+/*
+ * Returns the mask of bit `bit` within its word of a bitset of arguments
+ */
+#define BIT_MASK(bit) ((uint64_t)1 << ((bit) % 64))
+
+/*
+ * Marks `arg` as given in the parser's bitset of present arguments
+ */
+#define MARK_PRESENT(parser, arg)                                              \
+    ((parser)->present_[(arg)->bit_ / 64] |= BIT_MASK((arg)->bit_))
+
+/*
+ * Default prefixes enabling and disabling the flags of a feature flag set
+ */
+#define FLAG_ENABLE_PREFIX "--enable-"
+#define FLAG_DISABLE_PREFIX "--no-"
+
+/*
+ * Returns the prefixes enabling (`j` is 0) or disabling (`j` is 1) the flags of
+ * `set`
+ */
+#define FLAG_PREFIX(set, j)                                                    \
+    ((j) == 0 ? ((set)->enable_prefix_ ? (set)->enable_prefix_                 \
+                                       : FLAG_ENABLE_PREFIX)                   \
+              : ((set)->disable_prefix_ ? (set)->disable_prefix_               \
+                                        : FLAG_DISABLE_PREFIX))
+
+/*
+ * Prints the placeholder for a value of the argument, which is the name of a
+ * positional argument, or the upper-case name or flag of an option. Helper for
+ * `print_values`
+ */
+static void print_metavar(argparse_arg_t *arg) {
+    if (arg->name_ && arg->name_[0] != '-') {
+        printf("%s", arg->name_);
+    } else if (arg->name_) {
+        size_t i = 2;
+        while (arg->name_[i]) {
+            printf("%c",
+                   arg->name_[i] == '-' ? '_' : TO_UPPER(arg->name_[i]));
+            i++;
+        }
+    } else {
+        printf("%c", TO_UPPER(arg->flag_));
+    }
+}
+
+/*
+ * Prints the placeholders for the values the argument takes, repeated for the
+ * number of values of an argument with `nargs_`. Helper for
+ * `argparse_print_help`
+ */
+static void print_values(argparse_arg_t *arg) {
+    if (arg->type_ == ARGPARSE_DICT_TYPE) {
+        printf(" KEY=VALUE");
+        return;
+    }
+    if (arg->nargs_ == REMAINDER) {
+        printf(" ...");
+        return;
+    }
+    if (arg->nargs_ == ZERO_OR_MORE || arg->nargs_ == ONE_OR_MORE) {
+        if (arg->nargs_ == ONE_OR_MORE) {
+            printf(" ");
+            print_metavar(arg);
+        }
+        printf(" [");
+        print_metavar(arg);
+        printf(" ...]");
+        return;
+    }
+    for (int i = 0; i < (arg->nargs_ ? arg->nargs_ : 1); i++) {
+        printf(" ");
+        print_metavar(arg);
+    }
+}
+
 /*
  * Prints the possible choices for the argument in a comma-delimited list. Wraps
  * choices in curly braces if curly is true. Helper for `argparse_print_help`
@@ -127,7 +302,22 @@ static void print_choices(argparse_arg_t *arg, bool curly) {
             case ARGPARSE_FLOAT_TYPE:
                 printf("%s%.3f", j ? "," : start, ((float *)arg->choices_)[j]);
                 break;
+            case ARGPARSE_INT64_TYPE:
+                printf("%s%" PRId64, j ? "," : start,
+                       ((int64_t *)arg->choices_)[j]);
+                break;
+            case ARGPARSE_UINT32_TYPE:
+                printf("%s%" PRIu32, j ? "," : start,
+                       ((uint32_t *)arg->choices_)[j]);
+                break;
+            case ARGPARSE_UINT64_TYPE:
+            case ARGPARSE_SIZE_TYPE:
+            case ARGPARSE_DURATION_TYPE:
+                printf("%s%" PRIu64, j ? "," : start,
+                       ((uint64_t *)arg->choices_)[j]);
+                break;
             case ARGPARSE_STRING_TYPE:
+            case ARGPARSE_ENUM_TYPE:
                 printf("%s\"%s\"", j ? "," : start,
                        ((const char **)arg->choices_)[j]);
                 break;
@@ -166,19 +356,8 @@ void argparse_print_help(argument_parser_t *parser) {
             printf("%s", arg->name_);
         }
 
-        if (arg->action_ == ARGPARSE_STORE_ACTION && arg->choices_ == NULL) {
-            if (arg->name_) {
-                size_t i = 2;
-                printf(" ");
-                while (arg->name_[i]) {
-                    printf("%c", arg->name_[i] == '-'
-                                     ? '_'
-                                     : TO_UPPER(arg->name_[i]));
-                    i++;
-                }
-            } else {
-                printf(" %c", TO_UPPER(arg->flag_));
-            }
+        if (TAKES_VALUE(arg) && arg->choices_ == NULL) {
+            print_values(arg);
         }
 
         print_choices(arg, true);
@@ -187,11 +366,22 @@ void argparse_print_help(argument_parser_t *parser) {
 
         arg = arg->next_;
     }
+    for (argparse_flag_set_t *set = parser->flag_sets_; set;
+         set = set->next_) {
+        printf(" [%sFLAG | %sFLAG]", FLAG_PREFIX(set, 0), FLAG_PREFIX(set, 1));
+    }
     arg = parser->positional_args_;
     while (arg) {
-        printf(" %s", arg->name_);
+        print_values(arg);
         arg = arg->next_;
     }
+    for (argparse_subcommand_t *cmd = parser->subcommands_; cmd;
+         cmd = cmd->next_) {
+        printf("%s%s", cmd == parser->subcommands_ ? " {" : ",", cmd->name_);
+        if (cmd->next_ == NULL) {
+            printf("} ...");
+        }
+    }
     printf("\n");
 
     if (parser->description_) {
@@ -202,11 +392,23 @@ void argparse_print_help(argument_parser_t *parser) {
         printf("\npositional arguments:\n");
         arg = parser->positional_args_;
         while (arg) {
-            printf("  %-24s %s\n", arg->name_, arg->help_ ? arg->help_ : "");
+            printf("  %-24s %s", arg->name_, arg->help_ ? arg->help_ : "");
+            if (arg->env_) {
+                printf(" (env: %s)", arg->env_);
+            }
+            printf("\n");
             arg = arg->next_;
         }
     }
 
+    if (parser->subcommands_) {
+        printf("\nsubcommands:\n");
+        for (argparse_subcommand_t *cmd = parser->subcommands_; cmd;
+             cmd = cmd->next_) {
+            printf("  %-24s %s\n", cmd->name_, cmd->help_ ? cmd->help_ : "");
+        }
+    }
+
     printf("\noptions:\n");
     printf("  -h, %-20s %s\n", "--help", "show this help message and exit");
     arg = parser->options_;
@@ -214,15 +416,41 @@ void argparse_print_help(argument_parser_t *parser) {
         printf("  -%c, %-20s %s", arg->flag_ ? arg->flag_ : ' ',
                arg->name_ ? arg->name_ : "", arg->help_ ? arg->help_ : "");
         print_choices(arg, false);
+        if (arg->env_) {
+            printf(" (env: %s)", arg->env_);
+        }
         printf("\n");
         arg = arg->next_;
     }
+    for (argparse_flag_set_t *set = parser->flag_sets_; set;
+         set = set->next_) {
+        printf("  %sFLAG, %sFLAG\n", FLAG_PREFIX(set, 0), FLAG_PREFIX(set, 1));
+        printf("  %-24s %s (%zu flags)\n", "", set->help_ ? set->help_ : "",
+               set->num_flags_);
+    }
 
     if (parser->epilog_) {
         printf("\n%s\n", parser->epilog_);
     }
 }
 
+/*
+ * Block of the parser's arena. Allocations are bumped from the memory that
+ * follows the header, which is padded to keep that memory aligned
+ */
+struct argparse_arena_block {
+    struct argparse_arena_block *next;
+    size_t size;
+    size_t used;
+    max_align_t align;
+};
+
+/*
+ * Size of the blocks of the parser's arena. Larger allocations get a block of
+ * their own
+ */
+#define ARENA_BLOCK_SIZE 16384
+
 argparse_error_t argparse_init(argument_parser_t *parser, int argc, char **argv,
                                const char *description, const char *epilog) {
     parser->argc_ = --argc;
@@ -232,391 +460,3523 @@ argparse_error_t argparse_init(argument_parser_t *parser, int argc, char **argv,
     parser->epilog_ = epilog;
     parser->options_ = NULL;
     parser->positional_args_ = NULL;
+    parser->flag_sets_ = NULL;
+    parser->subcommands_ = NULL;
+    parser->fromfile_prefix_chars_ = NULL;
+    parser->token_cache_ = false;
+    parser->config_file_ = NULL;
+    parser->struct_ = NULL;
+    parser->struct_size_ = 0;
+    parser->expanded_argv_ = NULL;
+    parser->unexpanded_argv_ = NULL;
+    parser->unexpanded_argc_ = 0;
+    parser->mappings_ = NULL;
+    parser->num_mappings_ = 0;
+    parser->env_index_ = NULL;
+    parser->env_index_size_ = 0;
+    parser->num_env_args_ = 0;
+    parser->touched_log_ = NULL;
+    parser->num_touched_ = 0;
+    parser->touched_capacity_ = 0;
+    parser->subcommand_index_ = NULL;
+    parser->subcommand_index_size_ = 0;
+    parser->num_subcommands_ = 0;
+    parser->subcommand_ = NULL;
+    parser->subparser_ = NULL;
+    parser->bit_args_ = NULL;
+    parser->num_bits_ = 0;
+    parser->bit_words_ = 0;
+    parser->present_ = NULL;
+    parser->required_bits_ = NULL;
+    parser->count_bits_ = NULL;
+    parser->rules_ = NULL;
+    parser->lazy_ = false;
+    parser->copy_strings_ = false;
+    parser->arena_ = NULL;
 
     return ARGPARSE_NO_ERROR();
 }
 
 /*
- * Checks if `string` starts with `prefix`
+ * Frees the parser of the selected subcommand, if any. Helper for
+ * `argparse_free`, `argparse_reset` and `parse_subcommand`
  */
-static bool starts_with(const char *string, const char *prefix) {
-    return strncmp(string, prefix, strlen(prefix)) == 0;
+static void free_subparser(argument_parser_t *parser) {
+    if (parser->subparser_) {
+        argparse_free(parser->subparser_);
+        free(parser->subparser_);
+    }
+    parser->subparser_ = NULL;
+    parser->subcommand_ = NULL;
 }
 
 /*
- * Checks if the flags or names match between two arguments. Helper for
- * checking whether a conflicting argument is added in `argparse_add_argument`
+ * Unmaps the response and config files mapped by the last parse, and restores
+ * the argument vector the response files were expanded from. Helper for
+ * `argparse_free` and `argparse_reset`
  */
-argparse_error_t check_added(argparse_arg_t *added, argparse_arg_t *arg) {
-    if (arg->flag_ && arg->flag_ == added->flag_) {
-        return ARGPARSE_CONFLICTING_OPTIONS_ERROR(
-            "argparse_add_argument: option string %s already in use\n", NULL,
-            arg->flag_);
+static void release_mappings(argument_parser_t *parser) {
+    for (size_t i = 0; i < parser->num_mappings_; i++) {
+        if (parser->mappings_[i].data_) {
+            munmap(parser->mappings_[i].data_, parser->mappings_[i].size_);
+        }
     }
+    free(parser->mappings_);
+    parser->mappings_ = NULL;
+    parser->num_mappings_ = 0;
 
-    if (arg->name_ && strcmp(arg->name_, added->name_) == 0) {
-        return ARGPARSE_CONFLICTING_OPTIONS_ERROR(
-            "argparse_add_argument: option string %s already in use\n",
-            arg->name_, 0);
+    if (parser->expanded_argv_) {
+        if (parser->argv_ == parser->expanded_argv_) {
+            parser->argv_ = parser->unexpanded_argv_;
+            parser->argc_ = parser->unexpanded_argc_;
+        }
+        free(parser->expanded_argv_);
+        parser->expanded_argv_ = NULL;
     }
+}
 
-    return ARGPARSE_NO_ERROR();
+/*
+ * Unlinks the arguments in the list starting at `arg`, so they can be added to
+ * another parser. Helper for `argparse_free`
+ */
+static void release_args(argparse_arg_t *arg) {
+    while (arg) {
+        argparse_arg_t *next = arg->next_;
+        arg->added_ = false;
+        arg->next_ = NULL;
+        arg = next;
+    }
 }
 
-argparse_error_t argparse_add_argument(argument_parser_t *parser,
-                                       argparse_arg_t *arg) {
-    // check that at least one of flag or name is provided
-    if (arg->flag_ == NO_FLAG &&
-        (arg->name_ == NO_NAME || strlen(arg->name_) == 0)) {
-        return ARGPARSE_INVALID_FLAG_OR_NAME_ERROR(
-            "argparse_add_argument: argument must "
-            "contain at least one of flag or name\n",
-            NULL);
+void argparse_free(argument_parser_t *parser) {
+    free_subparser(parser);
+    // the arguments are released before the arena holding parent instances
+    release_args(parser->options_);
+    release_args(parser->positional_args_);
+    parser->options_ = NULL;
+    parser->positional_args_ = NULL;
+    release_mappings(parser);
+    free(parser->env_index_);
+    free(parser->touched_log_);
+    free(parser->subcommand_index_);
+    free(parser->bit_args_);
+    free(parser->present_);
+    free(parser->required_bits_);
+    free(parser->count_bits_);
+    while (parser->arena_) {
+        struct argparse_arena_block *next = parser->arena_->next;
+        free(parser->arena_);
+        parser->arena_ = next;
     }
+    parser->env_index_ = NULL;
+    parser->env_index_size_ = 0;
+    parser->num_env_args_ = 0;
+    parser->touched_log_ = NULL;
+    parser->num_touched_ = 0;
+    parser->touched_capacity_ = 0;
+    parser->subcommand_index_ = NULL;
+    parser->subcommand_index_size_ = 0;
+    parser->num_subcommands_ = 0;
+    parser->bit_args_ = NULL;
+    parser->num_bits_ = 0;
+    parser->bit_words_ = 0;
+    parser->present_ = NULL;
+    parser->required_bits_ = NULL;
+    parser->count_bits_ = NULL;
+    parser->rules_ = NULL;
+}
 
-    // check that type is valid
-    switch (arg->type_) {
+/*
+ * Returns the size of the values of type `type`
+ */
+static size_t type_size(argparse_type_t type) {
+    switch (type) {
     case ARGPARSE_INT_TYPE:
+    case ARGPARSE_ENUM_TYPE:
+        return sizeof(int);
     case ARGPARSE_FLOAT_TYPE:
+        return sizeof(float);
     case ARGPARSE_BOOL_TYPE:
+        return sizeof(bool);
     case ARGPARSE_STRING_TYPE:
-        break;
+        return sizeof(const char *);
+    case ARGPARSE_DICT_TYPE:
+        return sizeof(argparse_dict_t);
+    case ARGPARSE_INT64_TYPE:
+        return sizeof(int64_t);
+    case ARGPARSE_UINT32_TYPE:
+        return sizeof(uint32_t);
+    case ARGPARSE_UINT64_TYPE:
+    case ARGPARSE_SIZE_TYPE:
+    case ARGPARSE_DURATION_TYPE:
+        return sizeof(uint64_t);
     default:
-        return ARGPARSE_INVALID_TYPE_ERROR(arg->type_);
+        return 0;
     }
+}
 
-    bool positional = arg->name_ && !starts_with(arg->name_, "-");
-    bool bool_action = false;
+/*
+ * Returns where the value of `arg` is stored, which is its field in the bound
+ * struct if it was created with a field, and `arg->value_` otherwise
+ */
+static void *value_ptr(argument_parser_t *parser, argparse_arg_t *arg) {
+    return arg->size_ ? (char *)parser->struct_ + arg->offset_ : arg->value_;
+}
 
-    // check that action is valid
-    // check that store and boolean actions have a bool type
-    // check that non-store actions do not provide choices
-    switch (arg->action_) {
-    case ARGPARSE_STORE_TRUE_ACTION:
-    case ARGPARSE_STORE_FALSE_ACTION:
-    case ARGPARSE_BOOLEAN_OPTIONAL_ACTION:
-        bool_action = true;
-        if (arg->type_ != ARGPARSE_BOOL_TYPE) {
-            return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
-                "argparse_add_argument: store true/false and boolean optional "
-                "actions must have bool type for %s\n",
-                arg->name_, arg->flag_);
-        }
-        goto remaining;
-    case ARGPARSE_COUNT_ACTION:
-        if (arg->type_ != ARGPARSE_INT_TYPE) {
-            return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
-                "argparse_add_argument: count action must have int type for %s",
-                arg->name_, arg->flag_);
+void argparse_bind_struct(argument_parser_t *parser, void *config,
+                          const void *defaults, size_t size) {
+    if (defaults) {
+        memcpy(config, defaults, size);
+    }
+    parser->struct_ = config;
+    parser->struct_size_ = size;
+}
+
+void argparse_reset(argument_parser_t *parser) {
+    for (size_t i = 0; i < parser->num_touched_; i++) {
+        argparse_touched_t *entry = &parser->touched_log_[i];
+        argparse_arg_t *arg = entry->arg_;
+        void *dest = value_ptr(parser, arg);
+        arg->count_ = 0;
+        arg->touched_ = false;
+        arg->num_values_ = 0;
+        arg->raw_ = NULL;
+        parser->present_[arg->bit_ / 64] &= ~BIT_MASK(arg->bit_);
+        if (dest == NULL) {
+            continue;
         }
-    remaining:
-        if (arg->choices_) {
-            return ARGPARSE_UNSUPPORTED_CHOICES_ERROR(arg->name_, arg->flag_);
+        if (IS_ARRAY(arg)) {
+            if (arg->capacity_ == 0) {
+                *(void **)dest = entry->default_.array_;
+            }
+            continue;
         }
-        if (positional) {
-            return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
-                "argparse_add_argument: positional argument %s must have store "
-                "action\n",
-                arg->name_, 0);
+        if (arg->type_ == ARGPARSE_DICT_TYPE) {
+            argparse_dict_t *dict = dest;
+            dict->num_entries_ = 0;
+            if (dict->slots_) {
+                memset(dict->slots_, 0,
+                       dict->num_slots_ * sizeof(*dict->slots_));
+            }
+            continue;
         }
-        if (arg->required_) {
-            return ARGPARSE_UNSUPPORTED_REQUIRE_ERROR(arg->name_, arg->flag_);
+        memcpy(dest, &entry->default_, type_size(arg->type_));
+    }
+    parser->num_touched_ = 0;
+
+    if (parser->subparser_) {
+        argparse_reset(parser->subparser_);
+    }
+    free_subparser(parser);
+    // values pointing into the mapped files were restored above
+    release_mappings(parser);
+
+    for (argparse_flag_set_t *set = parser->flag_sets_; set;
+         set = set->next_) {
+        if (!set->touched_) {
+            continue;
         }
-        __attribute__((fallthrough));
-    case ARGPARSE_STORE_ACTION:
-        if (!bool_action && arg->type_ == ARGPARSE_BOOL_TYPE) {
-            return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
-                "argparse_add_argument: store or count actions must have "
-                "non-bool type for %s\n",
-                arg->name_, arg->flag_);
+        size_t words = ARGPARSE_FLAG_WORDS(set->num_flags_);
+        memset(set->set_, 0, 2 * words * sizeof(*set->set_));
+        if (set->defaults_) {
+            memcpy(set->bits_, set->defaults_, words * sizeof(*set->bits_));
+        } else {
+            memset(set->bits_, 0, words * sizeof(*set->bits_));
         }
-        break;
-    default:
-        return ARGPARSE_INVALID_ACTION_ERROR(arg->action_);
+        set->touched_ = false;
     }
+}
 
-    // check that positional argument does not have a flag as well
-    if (positional && arg->flag_) {
-        return ARGPARSE_INVALID_FLAG_OR_NAME_ERROR(
-            "argparse_add_argument: option string '%s' must start with '-'\n",
-            arg->name_);
-    }
+/*
+ * Rounds `n` up to the alignment of arena allocations
+ */
+#define ARENA_ALIGN(n)                                                         \
+    (((n) + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1))
 
-    // check that optional argument name is not just '--'
-    if (arg->name_ && !positional && strlen(arg->name_) == 2) {
-        return ARGPARSE_INVALID_FLAG_OR_NAME_ERROR(
-            "argparse_add_argument: must provide name for options like '--'\n",
-            NULL);
+void *argparse_arena_alloc(argument_parser_t *parser, size_t size) {
+    size = ARENA_ALIGN(size ? size : 1);
+    struct argparse_arena_block *block = parser->arena_;
+    if (block && block->size - block->used >= size) {
+        void *res = (char *)(block + 1) + block->used;
+        block->used += size;
+        return res;
     }
 
-    // checks that flag or name does not overlap with help options
-    if (arg->flag_ == 'h') {
-        return ARGPARSE_CONFLICTING_OPTIONS_ERROR(
-            "argparse_add_argument: -h flag reserved for help\n", NULL, 0);
+    // start a new block, or give a large allocation a block of its own behind
+    // the current one so the rest of the current block is not wasted
+    bool dedicated = size > ARENA_BLOCK_SIZE / 4;
+    size_t block_size = dedicated ? size : ARENA_BLOCK_SIZE;
+    struct argparse_arena_block *new_block =
+        malloc(sizeof(*new_block) + block_size);
+    if (new_block == NULL) {
+        return NULL;
     }
-    if (arg->name_ && strcmp(arg->name_, "--help") == 0) {
-        return ARGPARSE_CONFLICTING_OPTIONS_ERROR(
-            "argparse_add_argument: --help option string reserved for help\n",
-            NULL, 0);
+    new_block->size = block_size;
+    new_block->used = size;
+    if (dedicated && block) {
+        new_block->next = block->next;
+        block->next = new_block;
+    } else {
+        new_block->next = block;
+        parser->arena_ = new_block;
     }
+    return new_block + 1;
+}
 
-    // check that flag and name are unused
-    argparse_arg_t *added =
-        positional ? parser->positional_args_ : parser->options_;
-    argparse_arg_t *added_prev = NULL;
-
-    argparse_error_t error;
-    while (added) {
-        error = check_added(added, arg);
-        CHECK_ERROR(error);
-        added_prev = added;
-        added = added->next_;
+argparse_arg_t *argparse_arena_arg(argument_parser_t *parser,
+                                   const argparse_arg_t *arg) {
+    argparse_arg_t *res = argparse_arena_alloc(parser, sizeof(*res));
+    if (res) {
+        memcpy(res, arg, sizeof(*res));
     }
+    return res;
+}
 
-    if (added_prev) {
-        added_prev->next_ = arg;
-    } else {
-        if (positional) {
-            parser->positional_args_ = arg;
-        } else {
-            parser->options_ = arg;
-        }
+const char *argparse_arena_strdup(argument_parser_t *parser,
+                                  const char *string) {
+    size_t len = strlen(string) + 1;
+    char *res = argparse_arena_alloc(parser, len);
+    if (res) {
+        memcpy(res, string, len);
     }
+    return res;
+}
 
-    return ARGPARSE_NO_ERROR();
+/*
+ * Checks if `string` starts with `prefix`
+ */
+static bool starts_with(const char *string, const char *prefix) {
+    return strncmp(string, prefix, strlen(prefix)) == 0;
 }
 
-argparse_error_t argparse_add_arguments(argument_parser_t *parser,
-                                        argparse_arg_t *args, size_t num_args) {
-    argparse_error_t error;
-    for (size_t i = 0; i < num_args; i++) {
-        error = argparse_add_argument(parser, &args[i]);
-        CHECK_ERROR(error);
+/*
+ * Checks if the flags or names match between two arguments. Helper for
+ * checking whether a conflicting argument is added in `argparse_add_argument`
+ */
+argparse_error_t check_added(argparse_arg_t *added, argparse_arg_t *arg) {
+    if (arg->flag_ && arg->flag_ == added->flag_) {
+        return ARGPARSE_CONFLICTING_OPTIONS_ERROR(
+            "argparse_add_argument: option string %s already in use\n", NULL,
+            arg->flag_);
+    }
+
+    if (arg->name_ && strcmp(arg->name_, added->name_) == 0) {
+        return ARGPARSE_CONFLICTING_OPTIONS_ERROR(
+            "argparse_add_argument: option string %s already in use\n",
+            arg->name_, 0);
     }
+
     return ARGPARSE_NO_ERROR();
 }
 
 /*
- * Struct to store flag, name or index to search in list of arguments. The `tag`
- * field indicates which member of `u` to access. `prefix` should be unused
- * except when prepending a prefix when searching for a name
+ * Offset basis and prime of the 64-bit FNV-1a hash
  */
-typedef struct {
-    union {
-        char flag;
-        const char *name;
-        size_t index;
-    } u;
-    const char *prefix;
-    enum { FLAG_TO_FIND, NAME_TO_FIND, INDEX_TO_FIND } tag;
-} arg_to_find;
+#define FNV_OFFSET 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
 
 /*
- * Find an argument `arg` in the `arg_list`. Checks flag, name or index member
- * based on the tag
+ * Hashes the `len` bytes of `name` using FNV-1a. Used to index names in the
+ * parser's hash tables
+ */
+static uint64_t hash_name(const char *name, size_t len) {
+    uint64_t hash = FNV_OFFSET;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/*
+ * Finds the slot of the environment index holding the variable `name` of
+ * length `len`, or the empty slot where it would be inserted. The index must
+ * have at least one empty slot
+ */
+static argparse_env_slot_t *find_env_slot(argument_parser_t *parser,
+                                          const char *name, size_t len) {
+    size_t mask = parser->env_index_size_ - 1;
+    size_t i = hash_name(name, len) & mask;
+    for (;; i = (i + 1) & mask) {
+        argparse_env_slot_t *slot = &parser->env_index_[i];
+        if (slot->arg_ == NULL || (strncmp(slot->arg_->env_, name, len) == 0 &&
+                                   slot->arg_->env_[len] == '\0')) {
+            return slot;
+        }
+    }
+}
+
+/*
+ * Adds the environment variable declared by `arg` to the parser's index,
+ * doubling the index when it becomes half full. Helper for
+ * `argparse_add_argument`
+ */
+static argparse_error_t index_env(argument_parser_t *parser,
+                                  argparse_arg_t *arg) {
+    if (parser->num_env_args_ + 1 > parser->env_index_size_ / 2) {
+        argparse_env_slot_t *old = parser->env_index_;
+        size_t old_size = parser->env_index_size_;
+        size_t size = old_size ? old_size * 2 : 16;
+        parser->env_index_ = calloc(size, sizeof(*parser->env_index_));
+        if (parser->env_index_ == NULL) {
+            parser->env_index_ = old;
+            return ARGPARSE_OUT_OF_MEMORY_ERROR(
+                "argparse_add_argument: out of memory indexing %s\n",
+                arg->env_);
+        }
+        parser->env_index_size_ = size;
+        for (size_t i = 0; i < old_size; i++) {
+            if (old[i].arg_) {
+                *find_env_slot(parser, old[i].arg_->env_,
+                               strlen(old[i].arg_->env_)) = old[i];
+            }
+        }
+        free(old);
+    }
+
+    argparse_env_slot_t *slot =
+        find_env_slot(parser, arg->env_, strlen(arg->env_));
+    if (slot->arg_) {
+        return ARGPARSE_CONFLICTING_OPTIONS_ERROR(
+            "argparse_add_argument: environment variable %s already in use\n",
+            arg->env_, 0);
+    }
+    slot->arg_ = arg;
+    slot->value_ = NULL;
+    parser->num_env_args_++;
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Perfect hash of the choices of an enum argument, built by hash and
+ * displace. A choice hashed with seed 0 to bucket `b` is in the slot given
+ * directly by `displacements[b]` if it is negative, as `-slot - 1`, and in the
+ * slot it hashes to with seed `displacements[b]` otherwise. `slots` holds the
+ * index of the choice in each slot, or -1 if the slot is empty
+ */
+struct argparse_enum_index {
+    size_t num_slots;
+    int32_t *displacements;
+    int32_t slots[];
+};
+
+/*
+ * Hashes the `len` bytes of `name` with `seed`, using FNV-1a from a seeded
+ * state followed by folding the high bits into the low bits used for slots
+ */
+static uint64_t hash_choice(const char *name, size_t len, uint64_t seed) {
+    uint64_t hash = FNV_OFFSET ^ (seed * 0x9E3779B97F4A7C15ULL);
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * FNV_PRIME;
+    }
+    return hash ^ (hash >> 32);
+}
+
+/*
+ * Returns the index of the choice of the enum argument `arg` equal to `value`,
+ * or -1 if there is none. Helper for `store_value`
+ */
+static int find_enum(const argparse_arg_t *arg, const char *value) {
+    const struct argparse_enum_index *index = arg->enum_index_;
+    size_t mask = index->num_slots - 1, len = strlen(value);
+    int32_t d = index->displacements[hash_choice(value, len, 0) & mask];
+    size_t slot = d < 0 ? (size_t)(-(int64_t)d - 1)
+                        : hash_choice(value, len, (uint64_t)d) & mask;
+    int32_t i = index->slots[slot];
+    if (i < 0 || strcmp(((const char **)arg->choices_)[i], value) != 0) {
+        return -1;
+    }
+    return i;
+}
+
+/*
+ * Builds the perfect hash of the choices of the enum argument `arg` in the
+ * parser's arena. Buckets are placed largest first, each with the first seed
+ * sending all of its choices to distinct empty slots, and buckets of a single
+ * choice then fill the remaining slots directly. Helper for
+ * `argparse_add_argument`
+ */
+static argparse_error_t index_enum(argument_parser_t *parser,
+                                   argparse_arg_t *arg) {
+    const char **choices = arg->choices_;
+    size_t n = arg->num_choices_, size = 1;
+    while (size < n) {
+        size *= 2;
+    }
+    size_t mask = size - 1;
+
+    struct argparse_enum_index *index = argparse_arena_alloc(
+        parser, sizeof(*index) + 2 * size * sizeof(*index->slots));
+    // choices sorted by bucket, `start[b]` being the first of bucket `b`
+    size_t *order = malloc(n * sizeof(*order));
+    size_t *start = calloc(size + 1, sizeof(*start));
+    size_t *buckets = malloc(n * sizeof(*buckets));
+    if (index == NULL || order == NULL || start == NULL || buckets == NULL) {
+        free(order);
+        free(start);
+        free(buckets);
+        return ARGPARSE_OUT_OF_MEMORY_ERROR(
+            "argparse_add_argument: out of memory indexing choices of %s\n",
+            arg->name_);
+    }
+    index->num_slots = size;
+    index->displacements = index->slots + size;
+    for (size_t i = 0; i < size; i++) {
+        index->slots[i] = -1;
+        index->displacements[i] = 0;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        buckets[i] = hash_choice(choices[i], strlen(choices[i]), 0) & mask;
+        start[buckets[i] + 1]++;
+    }
+    size_t max_bucket = 0;
+    for (size_t b = 0; b < size; b++) {
+        if (start[b + 1] > max_bucket) {
+            max_bucket = start[b + 1];
+        }
+        start[b + 1] += start[b];
+    }
+    // filling moves `start[b]` to the end of bucket `b`, shift it back
+    for (size_t i = 0; i < n; i++) {
+        order[start[buckets[i]]++] = i;
+    }
+    for (size_t b = size; b > 0; b--) {
+        start[b] = start[b - 1];
+    }
+    start[0] = 0;
+
+    argparse_error_t error = ARGPARSE_NO_ERROR();
+    for (size_t count = max_bucket; count > 1; count--) {
+        for (size_t b = 0; b < size; b++) {
+            const size_t *bucket = order + start[b];
+            if (start[b + 1] - start[b] != count) {
+                continue;
+            }
+            // equal choices always share a bucket
+            for (size_t i = 0; i < count; i++) {
+                for (size_t j = i + 1; j < count; j++) {
+                    if (strcmp(choices[bucket[i]], choices[bucket[j]]) == 0) {
+                        error = ARGPARSE_CONFLICTING_OPTIONS_ERROR(
+                            "argparse_add_argument: choice %s repeated\n",
+                            choices[bucket[i]], arg->flag_);
+                        goto cleanup;
+                    }
+                }
+            }
+            // try seeds until all choices land in distinct empty slots
+            size_t placed = 0;
+            int32_t d = 0;
+            while (placed < count) {
+                // undo the slots taken with the previous seed
+                while (placed > 0) {
+                    const char *choice = choices[bucket[--placed]];
+                    index->slots[hash_choice(choice, strlen(choice),
+                                             (uint64_t)d) &
+                                 mask] = -1;
+                }
+                if (++d == INT32_MAX) {
+                    error = ARGPARSE_CONFLICTING_OPTIONS_ERROR(
+                        "argparse_add_argument: failed to index choices of "
+                        "%s\n",
+                        arg->name_, arg->flag_);
+                    goto cleanup;
+                }
+                for (; placed < count; placed++) {
+                    const char *choice = choices[bucket[placed]];
+                    size_t slot =
+                        hash_choice(choice, strlen(choice), (uint64_t)d) &
+                        mask;
+                    if (index->slots[slot] >= 0) {
+                        break;
+                    }
+                    index->slots[slot] = (int32_t)bucket[placed];
+                }
+            }
+            index->displacements[b] = d;
+        }
+    }
+    // single choices go straight into the remaining empty slots
+    for (size_t b = 0, slot = 0; b < size; b++) {
+        if (start[b + 1] - start[b] == 1) {
+            while (index->slots[slot] >= 0) {
+                slot++;
+            }
+            index->slots[slot] = (int32_t)order[start[b]];
+            index->displacements[b] = -(int32_t)slot - 1;
+        }
+    }
+    arg->enum_index_ = index;
+
+cleanup:
+    free(order);
+    free(start);
+    free(buckets);
+    return error;
+}
+
+/*
+ * Assigns `arg` the next bit of the parser's bitsets of arguments, doubling
+ * the bitsets when they are full, and records whether it is required or
+ * counted. The arrays are all allocated before any is replaced, so a failure
+ * leaves them matching `bit_words_`. Helper for `argparse_add_argument`
+ */
+static argparse_error_t assign_bit(argument_parser_t *parser,
+                                   argparse_arg_t *arg) {
+    if (parser->num_bits_ == 64 * parser->bit_words_) {
+        size_t words = parser->bit_words_ ? 2 * parser->bit_words_ : 1;
+        argparse_arg_t **args = malloc(64 * words * sizeof(*args));
+        uint64_t *bits[3];
+        bool ok = args != NULL;
+        for (size_t i = 0; i < 3; i++) {
+            bits[i] = calloc(words, sizeof(*bits[i]));
+            ok = ok && bits[i] != NULL;
+        }
+        if (!ok) {
+            free(args);
+            for (size_t i = 0; i < 3; i++) {
+                free(bits[i]);
+            }
+            return ARGPARSE_OUT_OF_MEMORY_ERROR(
+                "argparse_add_argument: out of memory adding %s\n",
+                arg->name_ ? arg->name_ : "argument");
+        }
+
+        uint64_t **bitsets[] = {&parser->present_, &parser->required_bits_,
+                                &parser->count_bits_};
+        for (size_t i = 0; i < 3; i++) {
+            if (parser->bit_words_) {
+                memcpy(bits[i], *bitsets[i],
+                       parser->bit_words_ * sizeof(*bits[i]));
+            }
+            free(*bitsets[i]);
+            *bitsets[i] = bits[i];
+        }
+        if (parser->num_bits_) {
+            memcpy(args, parser->bit_args_, parser->num_bits_ * sizeof(*args));
+        }
+        free(parser->bit_args_);
+        parser->bit_args_ = args;
+        parser->bit_words_ = words;
+    }
+
+    size_t bit = parser->num_bits_++;
+    arg->bit_ = bit;
+    parser->bit_args_[bit] = arg;
+    if (arg->required_ && arg->nargs_ != ZERO_OR_MORE &&
+        arg->nargs_ != REMAINDER) {
+        parser->required_bits_[bit / 64] |= BIT_MASK(bit);
+    }
+    if (arg->action_ == ARGPARSE_COUNT_ACTION) {
+        parser->count_bits_[bit / 64] |= BIT_MASK(bit);
+    }
+    return ARGPARSE_NO_ERROR();
+}
+
+argparse_error_t argparse_add_argument(argument_parser_t *parser,
+                                       argparse_arg_t *arg) {
+    // check that the argument is not linked into a parser already, as its
+    // `next_` and state belong to that parser
+    if (arg->added_) {
+        return ARGPARSE_CONFLICTING_OPTIONS_ERROR(
+            "argparse_add_argument: %s was already added to a parser\n",
+            arg->name_, arg->flag_);
+    }
+
+    // check that at least one of flag or name is provided
+    if (arg->flag_ == NO_FLAG &&
+        (arg->name_ == NO_NAME || strlen(arg->name_) == 0)) {
+        return ARGPARSE_INVALID_FLAG_OR_NAME_ERROR(
+            "argparse_add_argument: argument must "
+            "contain at least one of flag or name\n",
+            NULL);
+    }
+
+    // check that type is valid
+    switch (arg->type_) {
+    case ARGPARSE_INT_TYPE:
+    case ARGPARSE_FLOAT_TYPE:
+    case ARGPARSE_BOOL_TYPE:
+    case ARGPARSE_STRING_TYPE:
+    case ARGPARSE_INT64_TYPE:
+    case ARGPARSE_UINT32_TYPE:
+    case ARGPARSE_UINT64_TYPE:
+    case ARGPARSE_SIZE_TYPE:
+    case ARGPARSE_DURATION_TYPE:
+        break;
+    case ARGPARSE_DICT_TYPE:
+        // check that each occurrence stores a single pair
+        if (arg->action_ != ARGPARSE_STORE_ACTION || arg->nargs_ ||
+            arg->delimiter_) {
+            return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
+                "argparse_add_argument: dictionary %s must store a single "
+                "value\n",
+                arg->name_, arg->flag_);
+        }
+        if (arg->choices_) {
+            return ARGPARSE_UNSUPPORTED_CHOICES_ERROR(arg->name_, arg->flag_);
+        }
+        break;
+    case ARGPARSE_ENUM_TYPE:
+        // check that there are names to map to indices
+        if (arg->choices_ == NULL || arg->num_choices_ == 0 ||
+            arg->num_choices_ > INT32_MAX) {
+            return ARGPARSE_UNSUPPORTED_CHOICES_ERROR(arg->name_, arg->flag_);
+        }
+        break;
+    default:
+        return ARGPARSE_INVALID_TYPE_ERROR(arg->type_);
+    }
+
+    // check that only store actions take several values
+    if (arg->nargs_ &&
+        (arg->nargs_ < REMAINDER || arg->action_ != ARGPARSE_STORE_ACTION)) {
+        return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
+            "argparse_add_argument: invalid number of values for %s\n",
+            arg->name_, arg->flag_);
+    }
+
+    // check that a buffer holds the fixed number of values of an occurrence
+    if (arg->nargs_ > 0 && arg->capacity_ &&
+        (size_t)arg->nargs_ > arg->capacity_) {
+        return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
+            "argparse_add_argument: buffer of %s holds fewer values than "
+            "nargs\n",
+            arg->name_, arg->flag_);
+    }
+
+    // check that lists are of numbers and take a single value per occurrence
+    if (arg->delimiter_) {
+        if ((arg->type_ != ARGPARSE_INT_TYPE &&
+             arg->type_ != ARGPARSE_FLOAT_TYPE) ||
+            arg->nargs_ || arg->action_ != ARGPARSE_STORE_ACTION) {
+            return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
+                "argparse_add_argument: list %s must store a single int or "
+                "float value\n",
+                arg->name_, arg->flag_);
+        }
+        if (arg->choices_) {
+            return ARGPARSE_UNSUPPORTED_CHOICES_ERROR(arg->name_, arg->flag_);
+        }
+    }
+
+    // check that bounds are only given for numbers
+    if (arg->bounds_ && arg->type_ != ARGPARSE_INT_TYPE &&
+        arg->type_ != ARGPARSE_FLOAT_TYPE && !IS_WIDE_INT(arg->type_)) {
+        return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
+            "argparse_add_argument: bounds of %s require numeric type\n",
+            arg->name_, arg->flag_);
+    }
+
+    // check that an argument bound to a struct field fits the field, which
+    // holds an array of values or the address of one for multiple values
+    if (arg->size_) {
+        size_t size = type_size(arg->type_);
+        if (IS_ARRAY(arg)) {
+            size = arg->capacity_ ? arg->capacity_ * size : sizeof(void *);
+        }
+        if (arg->size_ != size) {
+            return ARGPARSE_INVALID_FIELD_ERROR(
+                "argparse_add_argument: field size of %s does not match its "
+                "type\n",
+                arg->name_, arg->flag_);
+        }
+        if (parser->struct_ == NULL || arg->size_ > parser->struct_size_ ||
+            arg->offset_ > parser->struct_size_ - arg->size_) {
+            return ARGPARSE_INVALID_FIELD_ERROR(
+                "argparse_add_argument: field of %s lies outside the bound "
+                "struct\n",
+                arg->name_, arg->flag_);
+        }
+    }
+
+    bool positional = arg->name_ && !starts_with(arg->name_, "-");
+    bool bool_action = false;
+
+    // check that action is valid
+    // check that store and boolean actions have a bool type
+    // check that non-store actions do not provide choices
+    switch (arg->action_) {
+    case ARGPARSE_STORE_TRUE_ACTION:
+    case ARGPARSE_STORE_FALSE_ACTION:
+    case ARGPARSE_BOOLEAN_OPTIONAL_ACTION:
+        bool_action = true;
+        if (arg->type_ != ARGPARSE_BOOL_TYPE) {
+            return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
+                "argparse_add_argument: store true/false and boolean optional "
+                "actions must have bool type for %s\n",
+                arg->name_, arg->flag_);
+        }
+        goto remaining;
+    case ARGPARSE_COUNT_ACTION:
+        if (arg->type_ != ARGPARSE_INT_TYPE) {
+            return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
+                "argparse_add_argument: count action must have int type for %s",
+                arg->name_, arg->flag_);
+        }
+    remaining:
+        if (arg->choices_) {
+            return ARGPARSE_UNSUPPORTED_CHOICES_ERROR(arg->name_, arg->flag_);
+        }
+        if (positional) {
+            return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
+                "argparse_add_argument: positional argument %s must have store "
+                "action\n",
+                arg->name_, 0);
+        }
+        if (arg->required_) {
+            return ARGPARSE_UNSUPPORTED_REQUIRE_ERROR(arg->name_, arg->flag_);
+        }
+        __attribute__((fallthrough));
+    case ARGPARSE_CALLBACK_ACTION:
+        if (arg->action_ == ARGPARSE_CALLBACK_ACTION &&
+            arg->callback_ == NULL) {
+            return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
+                "argparse_add_argument: callback action must provide a "
+                "callback for %s\n",
+                arg->name_, arg->flag_);
+        }
+        __attribute__((fallthrough));
+    case ARGPARSE_APPEND_ACTION:
+        if (arg->action_ == ARGPARSE_APPEND_ACTION &&
+            (positional || arg->capacity_ == 0)) {
+            return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
+                "argparse_add_argument: append action must be an option with "
+                "a buffer of nonzero capacity for %s\n",
+                arg->name_, arg->flag_);
+        }
+        __attribute__((fallthrough));
+    case ARGPARSE_STORE_ACTION:
+        if (!bool_action && arg->type_ == ARGPARSE_BOOL_TYPE) {
+            return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
+                "argparse_add_argument: store, append, callback or count "
+                "actions must have non-bool type for %s\n",
+                arg->name_, arg->flag_);
+        }
+        break;
+    default:
+        return ARGPARSE_INVALID_ACTION_ERROR(arg->action_);
+    }
+
+    // check that the remainder is a view of the argument strings
+    if (arg->nargs_ == REMAINDER &&
+        (!positional || arg->type_ != ARGPARSE_STRING_TYPE || arg->capacity_ ||
+         arg->choices_)) {
+        return ARGPARSE_UNSUPPORTED_ACTION_ERROR(
+            "argparse_add_argument: remainder %s must be a string positional "
+            "argument without choices or a buffer\n",
+            arg->name_, arg->flag_);
+    }
+
+    // check that positional argument does not have a flag as well
+    if (positional && arg->flag_) {
+        return ARGPARSE_INVALID_FLAG_OR_NAME_ERROR(
+            "argparse_add_argument: option string '%s' must start with '-'\n",
+            arg->name_);
+    }
+
+    // check that optional argument name is not just '--'
+    if (arg->name_ && !positional && strlen(arg->name_) == 2) {
+        return ARGPARSE_INVALID_FLAG_OR_NAME_ERROR(
+            "argparse_add_argument: must provide name for options like '--'\n",
+            NULL);
+    }
+
+    // checks that flag or name does not overlap with help options
+    if (arg->flag_ == 'h') {
+        return ARGPARSE_CONFLICTING_OPTIONS_ERROR(
+            "argparse_add_argument: -h flag reserved for help\n", NULL, 0);
+    }
+    if (arg->name_ && strcmp(arg->name_, "--help") == 0) {
+        return ARGPARSE_CONFLICTING_OPTIONS_ERROR(
+            "argparse_add_argument: --help option string reserved for help\n",
+            NULL, 0);
+    }
+
+    // check that flag and name are unused
+    argparse_arg_t *added =
+        positional ? parser->positional_args_ : parser->options_;
+    argparse_arg_t *added_prev = NULL;
+
+    argparse_error_t error;
+    while (added) {
+        error = check_added(added, arg);
+        CHECK_ERROR(error);
+        added_prev = added;
+        added = added->next_;
+    }
+
+    if (arg->env_) {
+        error = index_env(parser, arg);
+        CHECK_ERROR(error);
+    }
+    if (arg->type_ == ARGPARSE_ENUM_TYPE) {
+        error = index_enum(parser, arg);
+        CHECK_ERROR(error);
+    }
+    // arrays of values come from the arena of the parser the argument is added
+    // to, such as a subparser built again for each parse
+    arg->arena_array_ = NULL;
+    arg->arena_capacity_ = 0;
+    error = assign_bit(parser, arg);
+    CHECK_ERROR(error);
+
+    arg->added_ = true;
+    arg->next_ = NULL;
+    if (added_prev) {
+        added_prev->next_ = arg;
+    } else {
+        if (positional) {
+            parser->positional_args_ = arg;
+        } else {
+            parser->options_ = arg;
+        }
+    }
+
+    return ARGPARSE_NO_ERROR();
+}
+
+argparse_error_t argparse_add_arguments(argument_parser_t *parser,
+                                        argparse_arg_t *args, size_t num_args) {
+    argparse_error_t error;
+    for (size_t i = 0; i < num_args; i++) {
+        error = argparse_add_argument(parser, &args[i]);
+        CHECK_ERROR(error);
+    }
+    return ARGPARSE_NO_ERROR();
+}
+
+argparse_error_t argparse_add_parent(argument_parser_t *parser,
+                                     const argparse_arg_t *args,
+                                     size_t num_args) {
+    if (num_args == 0) {
+        return ARGPARSE_NO_ERROR();
+    }
+
+    // the parser state of the arguments is per parser, so link instances of
+    // the arguments rather than `args` themselves
+    argparse_arg_t *instances =
+        argparse_arena_alloc(parser, num_args * sizeof(*instances));
+    if (instances == NULL) {
+        return ARGPARSE_OUT_OF_MEMORY_ERROR(
+            "argparse_add_parent: out of memory adding %s\n",
+            args[0].name_ ? args[0].name_ : "parent arguments");
+    }
+    memcpy(instances, args, num_args * sizeof(*instances));
+    for (size_t i = 0; i < num_args; i++) {
+        instances[i].added_ = false;
+    }
+    return argparse_add_arguments(parser, instances, num_args);
+}
+
+/*
+ * Finds the slot of the flag set's index holding the index plus one of the
+ * flag `name` of length `len`, or the empty slot where it would be inserted
+ */
+static uint32_t *find_flag_slot(argparse_flag_set_t *set, const char *name,
+                                size_t len) {
+    size_t mask = set->index_size_ - 1;
+    size_t i = hash_name(name, len) & mask;
+    for (;; i = (i + 1) & mask) {
+        uint32_t *slot = &set->index_[i];
+        if (*slot == 0) {
+            return slot;
+        }
+        const char *flag = set->names_[*slot - 1];
+        if (strncmp(flag, name, len) == 0 && flag[len] == '\0') {
+            return slot;
+        }
+    }
+}
+
+argparse_error_t argparse_add_flag_set(argument_parser_t *parser,
+                                       argparse_flag_set_t *set) {
+    if (set->names_ == NULL || set->bits_ == NULL || set->num_flags_ == 0 ||
+        set->num_flags_ >= UINT32_MAX) {
+        return ARGPARSE_INVALID_FLAG_OR_NAME_ERROR(
+            "argparse_add_flag_set: flag set must provide names and bits for "
+            "at least one flag\n",
+            NULL);
+    }
+
+    // keep the index at most half full
+    size_t size = 16;
+    while (size < 2 * set->num_flags_) {
+        size *= 2;
+    }
+    size_t words = ARGPARSE_FLAG_WORDS(set->num_flags_);
+    set->index_ = argparse_arena_alloc(parser, size * sizeof(*set->index_));
+    set->set_ = argparse_arena_alloc(parser, 2 * words * sizeof(*set->set_));
+    if (set->index_ == NULL || set->set_ == NULL) {
+        return ARGPARSE_OUT_OF_MEMORY_ERROR(
+            "argparse_add_flag_set: out of memory indexing flags of %s\n",
+            set->help_ ? set->help_ : "flag set");
+    }
+    memset(set->index_, 0, size * sizeof(*set->index_));
+    memset(set->set_, 0, 2 * words * sizeof(*set->set_));
+    set->index_size_ = size;
+    set->clear_ = set->set_ + words;
+
+    for (size_t i = 0; i < set->num_flags_; i++) {
+        const char *name = set->names_[i];
+        uint32_t *slot = find_flag_slot(set, name, strlen(name));
+        if (*slot) {
+            return ARGPARSE_CONFLICTING_OPTIONS_ERROR(
+                "argparse_add_flag_set: flag %s already in use\n", name, 0);
+        }
+        *slot = (uint32_t)i + 1;
+    }
+
+    if (set->defaults_) {
+        memcpy(set->bits_, set->defaults_, words * sizeof(*set->bits_));
+    } else {
+        memset(set->bits_, 0, words * sizeof(*set->bits_));
+    }
+    set->touched_ = false;
+    set->next_ = NULL;
+
+    argparse_flag_set_t **tail = &parser->flag_sets_;
+    while (*tail) {
+        tail = &(*tail)->next_;
+    }
+    *tail = set;
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Finds the slot of the subcommand index holding the subcommand `name`, or
+ * the empty slot where it would be inserted. The index must have at least one
+ * empty slot
+ */
+static argparse_subcommand_t **find_subcommand_slot(argument_parser_t *parser,
+                                                    const char *name) {
+    size_t mask = parser->subcommand_index_size_ - 1;
+    size_t i = hash_name(name, strlen(name)) & mask;
+    for (;; i = (i + 1) & mask) {
+        argparse_subcommand_t **slot = &parser->subcommand_index_[i];
+        if (*slot == NULL || strcmp((*slot)->name_, name) == 0) {
+            return slot;
+        }
+    }
+}
+
+argparse_error_t argparse_add_subcommand(argument_parser_t *parser,
+                                         argparse_subcommand_t *subcommand) {
+    if (subcommand->name_ == NULL || subcommand->name_[0] == '\0' ||
+        subcommand->name_[0] == '-' || subcommand->init_ == NULL) {
+        return ARGPARSE_INVALID_FLAG_OR_NAME_ERROR(
+            "argparse_add_subcommand: subcommand must provide a name not "
+            "starting with '-' and an init function\n",
+            subcommand->name_);
+    }
+
+    // keep the index at most half full
+    if (parser->num_subcommands_ + 1 > parser->subcommand_index_size_ / 2) {
+        argparse_subcommand_t **old = parser->subcommand_index_;
+        size_t old_size = parser->subcommand_index_size_;
+        size_t size = old_size ? old_size * 2 : 16;
+        parser->subcommand_index_ =
+            calloc(size, sizeof(*parser->subcommand_index_));
+        if (parser->subcommand_index_ == NULL) {
+            parser->subcommand_index_ = old;
+            return ARGPARSE_OUT_OF_MEMORY_ERROR(
+                "argparse_add_subcommand: out of memory indexing %s\n",
+                subcommand->name_);
+        }
+        parser->subcommand_index_size_ = size;
+        for (size_t i = 0; i < old_size; i++) {
+            if (old[i]) {
+                *find_subcommand_slot(parser, old[i]->name_) = old[i];
+            }
+        }
+        free(old);
+    }
+
+    argparse_subcommand_t **slot =
+        find_subcommand_slot(parser, subcommand->name_);
+    if (*slot) {
+        return ARGPARSE_CONFLICTING_OPTIONS_ERROR(
+            "argparse_add_subcommand: subcommand %s already in use\n",
+            subcommand->name_, 0);
+    }
+    *slot = subcommand;
+    parser->num_subcommands_++;
+
+    subcommand->next_ = NULL;
+    argparse_subcommand_t **tail = &parser->subcommands_;
+    while (*tail) {
+        tail = &(*tail)->next_;
+    }
+    *tail = subcommand;
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Looks up `arg_string` among the flags of the parser's feature flag sets and
+ * records the flag in the set or clear mask of its set, so a later occurrence
+ * overrides an earlier one. Returns whether a flag was found. Helper for
+ * `argparse_parse_args`
+ */
+static bool update_flag(argument_parser_t *parser, const char *arg_string) {
+    for (argparse_flag_set_t *set = parser->flag_sets_; set;
+         set = set->next_) {
+        for (int j = 0; j < 2; j++) {
+            const char *prefix = FLAG_PREFIX(set, j);
+            if (!starts_with(arg_string, prefix)) {
+                continue;
+            }
+            const char *name = arg_string + strlen(prefix);
+            uint32_t index = *find_flag_slot(set, name, strlen(name));
+            if (index-- == 0) {
+                continue;
+            }
+
+            uint64_t bit = UINT64_C(1) << (index % 64);
+            uint64_t *given = j == 0 ? set->set_ : set->clear_;
+            uint64_t *other = j == 0 ? set->clear_ : set->set_;
+            given[index / 64] |= bit;
+            other[index / 64] &= ~bit;
+            set->touched_ = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Applies the flags given in the parse to the defaults of each feature flag
+ * set, a word at a time. Helper for `finalise_args`
+ */
+static void finalise_flag_sets(argument_parser_t *parser) {
+    for (argparse_flag_set_t *set = parser->flag_sets_; set;
+         set = set->next_) {
+        if (!set->touched_) {
+            continue;
+        }
+        size_t words = ARGPARSE_FLAG_WORDS(set->num_flags_);
+        for (size_t w = 0; w < words; w++) {
+            uint64_t defaults = set->defaults_ ? set->defaults_[w] : 0;
+            set->bits_[w] = (defaults & ~set->clear_[w]) | set->set_[w];
+        }
+    }
+}
+
+/*
+ * Struct to store flag, name or index to search in list of arguments. The `tag`
+ * field indicates which member of `u` to access. `prefix` should be unused
+ * except when prepending a prefix when searching for a name, and `len` except
+ * when searching for the first `len` characters of a name
+ */
+typedef struct {
+    union {
+        char flag;
+        const char *name;
+        size_t index;
+    } u;
+    const char *prefix;
+    size_t len;
+    enum { FLAG_TO_FIND, NAME_TO_FIND, INDEX_TO_FIND } tag;
+} arg_to_find;
+
+/*
+ * Find an argument `arg` in the `arg_list`. Checks flag, name or index member
+ * based on the tag
  */
 static argparse_arg_t *find_arg(argparse_arg_t *arg_list, arg_to_find arg) {
     argparse_arg_t *curr_arg = arg_list;
 
-    size_t i = 0;
-    while (curr_arg) {
-        switch (arg.tag) {
-        case FLAG_TO_FIND:
-            if (arg.u.flag == curr_arg->flag_) {
-                return curr_arg;
+    size_t i = 0;
+    while (curr_arg) {
+        switch (arg.tag) {
+        case FLAG_TO_FIND:
+            if (arg.u.flag == curr_arg->flag_) {
+                return curr_arg;
+            }
+            break;
+        case NAME_TO_FIND:
+            if (curr_arg->name_ == NULL) {
+                break;
+            }
+            if (arg.prefix) {
+                if (starts_with(curr_arg->name_, arg.prefix) &&
+                    strcmp(arg.u.name, curr_arg->name_ + strlen(arg.prefix)) ==
+                        0) {
+                    return curr_arg;
+                }
+            } else if (arg.len) {
+                if (strncmp(arg.u.name, curr_arg->name_, arg.len) == 0 &&
+                    curr_arg->name_[arg.len] == '\0') {
+                    return curr_arg;
+                }
+            } else {
+                if (strcmp(arg.u.name, curr_arg->name_) == 0) {
+                    return curr_arg;
+                }
+            }
+            break;
+        case INDEX_TO_FIND:
+            if (arg.u.index == i) {
+                return curr_arg;
+            }
+            break;
+        default:
+            fprintf(stderr, "find_arg: should not ever get here\n");
+            exit(EXIT_FAILURE);
+        }
+
+        curr_arg = curr_arg->next_;
+        i++;
+    }
+
+    return NULL;
+}
+
+/*
+ * Records `arg` in the parser's touched log with its current value, the first
+ * time the argument is touched after the parser is initialised or reset, so
+ * `argparse_reset` can restore it. Must be called before `arg->count_` or the
+ * value of `arg` is changed
+ */
+static argparse_error_t touch_arg(argument_parser_t *parser,
+                                  argparse_arg_t *arg) {
+    if (arg->touched_) {
+        return ARGPARSE_NO_ERROR();
+    }
+
+    if (parser->num_touched_ == parser->touched_capacity_) {
+        size_t capacity =
+            parser->touched_capacity_ ? 2 * parser->touched_capacity_ : 8;
+        argparse_touched_t *log =
+            realloc(parser->touched_log_, capacity * sizeof(*log));
+        if (log == NULL) {
+            return ARGPARSE_OUT_OF_MEMORY_ERROR(
+                "argparse_parse_args: out of memory recording arguments\n",
+                NULL);
+        }
+        parser->touched_log_ = log;
+        parser->touched_capacity_ = capacity;
+    }
+
+    argparse_touched_t *entry = &parser->touched_log_[parser->num_touched_++];
+    entry->arg_ = arg;
+    void *dest = value_ptr(parser, arg);
+    if (dest == NULL) {
+        // callbacks need not store their values
+        arg->touched_ = true;
+        return ARGPARSE_NO_ERROR();
+    }
+    if (IS_ARRAY(arg)) {
+        // only the address of an arena array needs restoring
+        entry->default_.array_ = arg->capacity_ ? NULL : *(void **)dest;
+        arg->touched_ = true;
+        return ARGPARSE_NO_ERROR();
+    }
+    // the value is copied as bytes, as the destination need not hold a valid
+    // value of its type until the argument is given, and dictionaries are
+    // emptied on reset instead
+    if (arg->type_ != ARGPARSE_DICT_TYPE) {
+        memcpy(&entry->default_, dest, type_size(arg->type_));
+    }
+    arg->touched_ = true;
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Doubles the hash table of `dict`, or creates one of 16 slots, together with
+ * its entries, which take up to half the slots. The old arrays remain in the
+ * parser's arena until `argparse_free`, while a reset keeps the current ones,
+ * so a reused dictionary only grows past its largest size. Helper for
+ * `dict_insert`
+ */
+static bool dict_grow(argument_parser_t *parser, argparse_dict_t *dict) {
+    size_t num_slots = dict->num_slots_ ? 2 * dict->num_slots_ : 16;
+    uint32_t *slots = argparse_arena_alloc(parser, num_slots * sizeof(*slots));
+    argparse_dict_entry_t *entries =
+        argparse_arena_alloc(parser, num_slots / 2 * sizeof(*entries));
+    if (slots == NULL || entries == NULL || num_slots / 2 >= UINT32_MAX) {
+        return false;
+    }
+
+    memset(slots, 0, num_slots * sizeof(*slots));
+    if (dict->num_entries_) {
+        memcpy(entries, dict->entries_,
+               dict->num_entries_ * sizeof(*entries));
+    }
+    size_t mask = num_slots - 1;
+    for (size_t k = 0; k < dict->num_entries_; k++) {
+        size_t i = entries[k].hash_ & mask;
+        while (slots[i]) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = (uint32_t)k + 1;
+    }
+    dict->slots_ = slots;
+    dict->entries_ = entries;
+    dict->num_slots_ = num_slots;
+    return true;
+}
+
+/*
+ * Splits `pair` at the first '=' into slices of the key and value, and adds
+ * them to `dict`, handling a repeated key according to the dictionary's
+ * policy. Helper for `store_value`
+ */
+static argparse_error_t dict_insert(argument_parser_t *parser,
+                                    argparse_arg_t *arg, argparse_dict_t *dict,
+                                    const char *pair) {
+    const char *eq = strchr(pair, '=');
+    if (eq == NULL) {
+        return ARGPARSE_INVALID_VALUE_ERROR(
+            "argparse_parse_args: value for %s is not a KEY=VALUE pair\n",
+            arg->name_, arg->flag_);
+    }
+    size_t key_len = (size_t)(eq - pair);
+    const char *value = eq + 1;
+    uint64_t hash = hash_name(pair, key_len);
+
+    if (dict->num_entries_ == dict->num_slots_ / 2 &&
+        !dict_grow(parser, dict)) {
+        return ARGPARSE_OUT_OF_MEMORY_ERROR(
+            "argparse_parse_args: out of memory storing pairs of %s\n",
+            arg->name_ ? arg->name_ : "argument");
+    }
+
+    size_t mask = dict->num_slots_ - 1;
+    size_t i = hash & mask;
+    for (; dict->slots_[i]; i = (i + 1) & mask) {
+        argparse_dict_entry_t *entry = &dict->entries_[dict->slots_[i] - 1];
+        if (entry->hash_ != hash || entry->key_len_ != key_len ||
+            memcmp(entry->key_, pair, key_len) != 0) {
+            continue;
+        }
+        switch (dict->policy_) {
+        case ARGPARSE_DICT_LAST_WINS:
+            entry->value_ = value;
+            return ARGPARSE_NO_ERROR();
+        case ARGPARSE_DICT_FIRST_WINS:
+            return ARGPARSE_NO_ERROR();
+        default:
+            return ARGPARSE_DUPLICATE_KEY_ERROR(
+                "argparse_parse_args: repeated key in %s\n", pair);
+        }
+    }
+
+    dict->entries_[dict->num_entries_] = (argparse_dict_entry_t){
+        .key_ = pair, .key_len_ = key_len, .value_ = value, .hash_ = hash};
+    dict->slots_[i] = (uint32_t)++dict->num_entries_;
+    return ARGPARSE_NO_ERROR();
+}
+
+const char *argparse_dict_get(const argparse_dict_t *dict, const char *key) {
+    if (dict->num_slots_ == 0) {
+        return NULL;
+    }
+    size_t key_len = strlen(key);
+    uint64_t hash = hash_name(key, key_len);
+    size_t mask = dict->num_slots_ - 1;
+    for (size_t i = hash & mask; dict->slots_[i]; i = (i + 1) & mask) {
+        const argparse_dict_entry_t *entry =
+            &dict->entries_[dict->slots_[i] - 1];
+        if (entry->hash_ == hash && entry->key_len_ == key_len &&
+            memcmp(entry->key_, key, key_len) == 0) {
+            return entry->value_;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Sets `res` to `res * base + digit`, returning whether the result overflowed
+ * 64 bits. Helper for `parse_integer`
+ */
+static bool mul_add_overflow(uint64_t *res, uint64_t base, uint64_t digit) {
+#if defined(__GNUC__) || defined(__clang__)
+    bool overflow = __builtin_mul_overflow(*res, base, res);
+    return __builtin_add_overflow(*res, digit, res) | overflow;
+#else
+    bool overflow = *res > (UINT64_MAX - digit) / base;
+    *res = *res * base + digit;
+    return overflow;
+#endif
+}
+
+/*
+ * Returns the value of the digit `c` in bases up to 16, or 16 if it is not a
+ * digit. Helper for `parse_integer`
+ */
+static unsigned digit_value(char c) {
+    unsigned digit = (unsigned)(c - '0');
+    unsigned letter = (unsigned)((c | 0x20) - 'a');
+    return digit < 10 ? digit : letter < 6 ? letter + 10 : 16;
+}
+
+/*
+ * Unit suffix of a size or duration value, with the number of bytes or
+ * nanoseconds it stands for
+ */
+struct argparse_unit {
+    const char *suffix;
+    uint64_t scale;
+};
+
+/*
+ * Units of size values, which may also end in `B`
+ */
+static const struct argparse_unit size_units[] = {
+    {"", 1},
+    {"k", 1000},
+    {"K", 1000},
+    {"M", 1000000},
+    {"G", 1000000000},
+    {"T", 1000000000000},
+    {"Ki", (uint64_t)1 << 10},
+    {"Mi", (uint64_t)1 << 20},
+    {"Gi", (uint64_t)1 << 30},
+    {"Ti", (uint64_t)1 << 40},
+    {NULL, 0},
+};
+
+/*
+ * Units of duration values
+ */
+static const struct argparse_unit duration_units[] = {
+    {"ns", 1},
+    {"us", 1000},
+    {"ms", 1000000},
+    {"s", 1000000000},
+    {"m", 60000000000},
+    {"h", 3600000000000},
+    {NULL, 0},
+};
+
+/*
+ * Returns the scale of the unit `suffix` of a value of `arg`, a size or
+ * duration argument, or 0 if it is not a unit of the argument's type. Helper
+ * for `parse_integer`
+ */
+static uint64_t unit_scale(const argparse_arg_t *arg, const char *suffix) {
+    const struct argparse_unit *units = size_units;
+    size_t len = strlen(suffix);
+    if (arg->type_ == ARGPARSE_DURATION_TYPE) {
+        units = duration_units;
+    } else if (len && suffix[len - 1] == 'B') {
+        len--;
+    }
+    for (; units->suffix; units++) {
+        if (strncmp(units->suffix, suffix, len) == 0 &&
+            units->suffix[len] == '\0') {
+            return units->scale;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Converts the string `value` of the integer argument `arg` to its sign at
+ * `negative` and magnitude at `magnitude`, checking that it fits the
+ * argument's type. The value is decimal, or hexadecimal or octal with a `0x`
+ * or `0` prefix as for `strtol`. The decimal digits of a size or duration are
+ * followed by a unit, by which the value is scaled in the same pass. Overflow
+ * is accumulated as a flag across the digits and the scaling rather than
+ * checked on each one, and reported once at the end. Helper for `store_value`
+ * and `check_choices`
+ */
+static argparse_error_t parse_integer(argparse_arg_t *arg, const char *value,
+                                      bool *negative, uint64_t *magnitude) {
+    const char *p = value;
+    *negative = *p == '-';
+    p += *p == '-' || *p == '+';
+    bool units = arg->type_ == ARGPARSE_SIZE_TYPE ||
+                 arg->type_ == ARGPARSE_DURATION_TYPE;
+    unsigned base = 10;
+    if (!units && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        base = 16;
+        p += 2;
+    } else if (!units && p[0] == '0' && p[1] != '\0') {
+        base = 8;
+        p++;
+    }
+
+    const char *digits = p;
+    uint64_t res = 0;
+    bool overflow = false;
+    for (; *p; p++) {
+        unsigned digit = digit_value(*p);
+        if (digit >= base) {
+            break;
+        }
+        overflow |= mul_add_overflow(&res, base, digit);
+    }
+    if (p == digits || (*p && !units)) {
+        return ARGPARSE_INVALID_VALUE_ERROR(
+            "argparse_parse_args: value for %s is not an integer\n",
+            arg->name_, arg->flag_);
+    }
+    if (units) {
+        // a duration of zero needs no unit
+        uint64_t scale = *p || res ? unit_scale(arg, p) : 1;
+        if (scale == 0) {
+            return ARGPARSE_INVALID_VALUE_ERROR(
+                "argparse_parse_args: value for %s has an unknown unit\n",
+                arg->name_, arg->flag_);
+        }
+        overflow |= mul_add_overflow(&res, scale, 0);
+    }
+
+    *negative = *negative && res != 0;
+    switch (arg->type_) {
+    case ARGPARSE_INT64_TYPE:
+        overflow |= res > (uint64_t)INT64_MAX + *negative;
+        break;
+    case ARGPARSE_UINT32_TYPE:
+        overflow |= *negative || res > UINT32_MAX;
+        break;
+    default:
+        overflow |= *negative;
+        break;
+    }
+    if (overflow) {
+        return ARGPARSE_INT_RANGE_EXCEEDED_ERROR(
+            "argparse_parse_args: value for %s exceeds range of its type\n",
+            arg->name_, arg->flag_);
+    }
+    *magnitude = res;
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Splits the integer of type `type` at `value` into its sign at `negative` and
+ * magnitude at `magnitude`. Helper for `store_value` and `check_choices`
+ */
+static void split_integer(argparse_type_t type, const void *value,
+                          bool *negative, uint64_t *magnitude) {
+    switch (type) {
+    case ARGPARSE_INT64_TYPE: {
+        int64_t res = *(const int64_t *)value;
+        *negative = res < 0;
+        *magnitude = res < 0 ? (uint64_t)0 - (uint64_t)res : (uint64_t)res;
+        break;
+    }
+    case ARGPARSE_UINT32_TYPE:
+        *negative = false;
+        *magnitude = *(const uint32_t *)value;
+        break;
+    default:
+        *negative = false;
+        *magnitude = *(const uint64_t *)value;
+        break;
+    }
+}
+
+/*
+ * Stores the integer with sign `negative` and magnitude `magnitude`, which
+ * fits the type `type`, at `dest`. Helper for `store_value`
+ */
+static void join_integer(argparse_type_t type, void *dest, bool negative,
+                         uint64_t magnitude) {
+    switch (type) {
+    case ARGPARSE_INT64_TYPE:
+        // avoids converting magnitudes beyond INT64_MAX to int64_t
+        *(int64_t *)dest =
+            negative ? -(int64_t)(magnitude - 1) - 1 : (int64_t)magnitude;
+        break;
+    case ARGPARSE_UINT32_TYPE:
+        *(uint32_t *)dest = (uint32_t)magnitude;
+        break;
+    default:
+        *(uint64_t *)dest = magnitude;
+        break;
+    }
+}
+
+/*
+ * Compares the integer with sign `negative` and magnitude `magnitude` to the
+ * bound `bound`, returning a negative, zero or positive value as the integer
+ * is less than, equal to or greater than the bound. The comparison is exact,
+ * where converting a 64-bit integer to double would round it. Helper for
+ * `check_int_bounds`
+ */
+static int compare_bound(bool negative, uint64_t magnitude, double bound) {
+    if (negative != (bound < 0)) {
+        return negative ? -1 : 1;
+    }
+    double abs = negative ? -bound : bound;
+    int sign = negative ? -1 : 1;
+    if (!(abs < 18446744073709551616.0)) {
+        return -sign;
+    }
+    // truncating is exact past 2^53, where doubles have no fraction
+    uint64_t whole = (uint64_t)abs;
+    if (magnitude != whole) {
+        return magnitude < whole ? -sign : sign;
+    }
+    return abs > (double)whole ? -sign : 0;
+}
+
+/*
+ * Checks the integer with sign `negative` and magnitude `magnitude`, a value
+ * of `arg`, against its bounds. Helper for `store_value`
+ */
+static argparse_error_t check_int_bounds(argparse_arg_t *arg, bool negative,
+                                         uint64_t magnitude) {
+    unsigned bounds = arg->bounds_;
+    int min = compare_bound(negative, magnitude, arg->min_);
+    int max = compare_bound(negative, magnitude, arg->max_);
+    if (((bounds & ARGPARSE_MIN_INCLUSIVE) && min < 0) ||
+        ((bounds & ARGPARSE_MIN_EXCLUSIVE) && min <= 0) ||
+        ((bounds & ARGPARSE_MAX_INCLUSIVE) && max > 0) ||
+        ((bounds & ARGPARSE_MAX_EXCLUSIVE) && max >= 0)) {
+        return ARGPARSE_OUT_OF_BOUNDS_ERROR(
+            "argparse_parse_args: value for %s is out of bounds\n", arg->name_,
+            arg->flag_);
+    }
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Checks the converted value `value` of `arg` against its bounds. NaN lies
+ * outside any bound. Helper for `store_value` and `store_list`
+ */
+static argparse_error_t check_bounds(argparse_arg_t *arg, double value) {
+    unsigned bounds = arg->bounds_;
+    if (((bounds & ARGPARSE_MIN_INCLUSIVE) && !(value >= arg->min_)) ||
+        ((bounds & ARGPARSE_MIN_EXCLUSIVE) && !(value > arg->min_)) ||
+        ((bounds & ARGPARSE_MAX_INCLUSIVE) && !(value <= arg->max_)) ||
+        ((bounds & ARGPARSE_MAX_EXCLUSIVE) && !(value < arg->max_))) {
+        return ARGPARSE_OUT_OF_BOUNDS_ERROR(
+            "argparse_parse_args: value for %s is out of bounds\n", arg->name_,
+            arg->flag_);
+    }
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Stores `value` at `dest` as a value of `arg`, performing type-cast based on
+ * `arg->type_`. `value` is a string to convert if `string` is true, and a
+ * pointer to a value of the argument's type otherwise. Helper for
+ * `update_value` and `store_values`
+ */
+static argparse_error_t store_value(argument_parser_t *parser,
+                                    argparse_arg_t *arg, void *dest,
+                                    void *value, bool string) {
+    switch (arg->type_) {
+    case ARGPARSE_INT_TYPE: {
+        errno = 0;
+        long res;
+        res = string ? strtol(value, NULL, 0) : *(int *)value;
+        if (errno == ERANGE || res > INT32_MAX || res < INT32_MIN) {
+            return ARGPARSE_INT_RANGE_EXCEEDED_ERROR(
+                "argparse_parse_args: value for %s exceeds range of integer\n",
+                arg->name_, arg->flag_);
+        }
+        if (arg->bounds_) {
+            argparse_error_t error = check_bounds(arg, (double)res);
+            CHECK_ERROR(error);
+        }
+        *(int *)dest = (int)res;
+        break;
+    }
+    case ARGPARSE_FLOAT_TYPE: {
+        float res = string ? strtof(value, NULL) : *(float *)value;
+        if (arg->bounds_) {
+            argparse_error_t error = check_bounds(arg, res);
+            CHECK_ERROR(error);
+        }
+        *(float *)dest = res;
+        break;
+    }
+    case ARGPARSE_BOOL_TYPE:
+        *(bool *)dest = *(bool *)value;
+        break;
+    case ARGPARSE_INT64_TYPE:
+    case ARGPARSE_UINT32_TYPE:
+    case ARGPARSE_UINT64_TYPE:
+    case ARGPARSE_SIZE_TYPE:
+    case ARGPARSE_DURATION_TYPE: {
+        bool negative;
+        uint64_t magnitude;
+        argparse_error_t error = ARGPARSE_NO_ERROR();
+        if (string) {
+            error = parse_integer(arg, value, &negative, &magnitude);
+        } else {
+            split_integer(arg->type_, value, &negative, &magnitude);
+        }
+        CHECK_ERROR(error);
+        if (arg->bounds_) {
+            error = check_int_bounds(arg, negative, magnitude);
+            CHECK_ERROR(error);
+        }
+        join_integer(arg->type_, dest, negative, magnitude);
+        break;
+    }
+    case ARGPARSE_ENUM_TYPE: {
+        int res = string ? find_enum(arg, value) : *(int *)value;
+        if (res < 0) {
+            return ARGPARSE_INVALID_CHOICE_ERROR(arg->name_, arg->flag_);
+        }
+        *(int *)dest = res;
+        break;
+    }
+    case ARGPARSE_STRING_TYPE:
+        if (parser->copy_strings_) {
+            value = (void *)argparse_arena_strdup(parser, value);
+            if (value == NULL) {
+                return ARGPARSE_OUT_OF_MEMORY_ERROR(
+                    "argparse_parse_args: out of memory copying value of %s\n",
+                    arg->name_ ? arg->name_ : "argument");
+            }
+        }
+        *(const char **)dest = value;
+        break;
+    case ARGPARSE_DICT_TYPE:
+        if (parser->copy_strings_) {
+            value = (void *)argparse_arena_strdup(parser, value);
+            if (value == NULL) {
+                return ARGPARSE_OUT_OF_MEMORY_ERROR(
+                    "argparse_parse_args: out of memory copying value of %s\n",
+                    arg->name_ ? arg->name_ : "argument");
+            }
+        }
+        return dict_insert(parser, arg, dest, value);
+    default:
+        fprintf(stderr, "argparse_parse_args: should not ever get here\n");
+        exit(EXIT_FAILURE);
+    }
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Updates the value of `arg`, at `arg->value_` or in the bound struct, with
+ * `value`. Helper for `get_and_update_value`
+ */
+static argparse_error_t update_value(argument_parser_t *parser,
+                                     argparse_arg_t *arg, void *value,
+                                     bool string) {
+    argparse_error_t error = touch_arg(parser, arg);
+    CHECK_ERROR(error);
+    return store_value(parser, arg, value_ptr(parser, arg), value, string);
+}
+
+/*
+ * Checks that the string `value` matches one of the choices of `arg`, if any
+ * choices are provided. `arg_string` is reported as the offending argument on
+ * error. Helper for `get_and_update_value` and `bind_json_value`
+ */
+static argparse_error_t check_choices(argparse_arg_t *arg, const char *value,
+                                      const char *arg_string) {
+    // the choices of an enum are checked by looking the value up
+    bool found = arg->num_choices_ == 0 || arg->type_ == ARGPARSE_ENUM_TYPE;
+    for (size_t j = 0; j < arg->num_choices_ && !found; j++) {
+        switch (arg->type_) {
+        case ARGPARSE_INT_TYPE: {
+            errno = 0;
+            long res = strtol(value, NULL, 0);
+            if (errno == ERANGE || res > INT32_MAX || res < INT32_MIN) {
+                return ARGPARSE_INT_RANGE_EXCEEDED_ERROR(
+                    "argparse_parse_args: choice for %s exceeds range of "
+                    "integer\n",
+                    arg->name_, arg->flag_);
+            }
+            found = ((int *)arg->choices_)[j] == (int)res;
+            break;
+        }
+        case ARGPARSE_FLOAT_TYPE:
+            found = WITHIN(strtof(value, NULL), ((float *)arg->choices_)[j]);
+            break;
+        case ARGPARSE_BOOL_TYPE:
+            // non-store actions and bool types do not support choices
+            break;
+        case ARGPARSE_STRING_TYPE:
+            found = strcmp(((const char **)arg->choices_)[j], value) == 0;
+            break;
+        case ARGPARSE_INT64_TYPE:
+        case ARGPARSE_UINT32_TYPE:
+        case ARGPARSE_UINT64_TYPE:
+        case ARGPARSE_SIZE_TYPE:
+        case ARGPARSE_DURATION_TYPE: {
+            bool negative, choice_negative;
+            uint64_t magnitude, choice_magnitude;
+            argparse_error_t error =
+                parse_integer(arg, value, &negative, &magnitude);
+            CHECK_ERROR(error);
+            split_integer(arg->type_,
+                          (char *)arg->choices_ + j * type_size(arg->type_),
+                          &choice_negative, &choice_magnitude);
+            found = negative == choice_negative &&
+                    magnitude == choice_magnitude;
+            break;
+        }
+        default:
+            fprintf(stderr, "should not get here\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (!found) {
+        return ARGPARSE_INVALID_CHOICE_ERROR(arg_string, 0);
+    }
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Provides the array receiving `n` values of `arg` at `array`, which is the
+ * caller's buffer or an array allocated from the parser's arena. The arena
+ * array is kept by the argument and only replaced when it is too small, so a
+ * reused parser does not allocate again for each parse. Helper for
+ * `store_values` and `store_list`
+ */
+static argparse_error_t values_array(argument_parser_t *parser,
+                                     argparse_arg_t *arg, size_t n,
+                                     const char *arg_string, char **array) {
+    if (arg->capacity_) {
+        if (n > arg->capacity_) {
+            return ARGPARSE_CAPACITY_EXCEEDED_ERROR(
+                "argparse_parse_args: too many values for %s\n", arg_string);
+        }
+        *array = value_ptr(parser, arg);
+        return ARGPARSE_NO_ERROR();
+    }
+
+    if (n > arg->arena_capacity_ || arg->arena_array_ == NULL) {
+        size_t capacity = arg->arena_capacity_ * 2;
+        capacity = capacity > n ? capacity : n;
+        void *res =
+            argparse_arena_alloc(parser, capacity * type_size(arg->type_));
+        if (res == NULL) {
+            return ARGPARSE_OUT_OF_MEMORY_ERROR(
+                "argparse_parse_args: out of memory storing values of %s\n",
+                arg_string);
+        }
+        arg->arena_array_ = res;
+        arg->arena_capacity_ = capacity;
+    }
+    *array = arg->arena_array_;
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Stores the `n` strings in `values` as the array of values of `arg`, in the
+ * caller's buffer or in an array allocated from the parser's arena, checking
+ * each against the choices. `arg_string` is reported as the offending
+ * argument on error. Helper for `get_and_update_values` and `bind_value`
+ */
+static argparse_error_t store_values(argument_parser_t *parser,
+                                     argparse_arg_t *arg, char *const *values,
+                                     size_t n, const char *arg_string) {
+    char *array;
+    argparse_error_t error = values_array(parser, arg, n, arg_string, &array);
+    CHECK_ERROR(error);
+
+    size_t size = type_size(arg->type_);
+    for (size_t k = 0; k < n; k++) {
+        error = check_choices(arg, values[k], arg_string);
+        CHECK_ERROR(error);
+        error = store_value(parser, arg, array + k * size, values[k], true);
+        CHECK_ERROR(error);
+    }
+
+    if (arg->capacity_ == 0) {
+        *(void **)value_ptr(parser, arg) = array;
+    }
+    arg->num_values_ = n;
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Checks whether the 8 bytes in the word `w`, loaded in little-endian order,
+ * are all ASCII digits
+ */
+#define ALL_DIGITS(w)                                                          \
+    (((w) & 0xF0F0F0F0F0F0F0F0ULL) == 0x3030303030303030ULL &&                 \
+     (((w) + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) ==                \
+         0x3030303030303030ULL)
+
+/*
+ * Converts the 8 ASCII digits in the word `w`, loaded in little-endian order,
+ * to their value with three multiplications, combining pairs of digits, then
+ * pairs of pairs, then the two halves
+ */
+static uint64_t parse_eight_digits(uint64_t w) {
+    w -= 0x3030303030303030ULL;
+    w = (w * 10) + (w >> 8);
+    return (((w & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+            (((w >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >>
+           32;
+}
+
+/*
+ * Converts the list element from `start` to `end` to an int at `out`, with the
+ * same bases as a single int value. Plain decimal elements are converted 8
+ * digits at a time where the target is little-endian, and other elements, such
+ * as octal and hexadecimal ones, fall back to `strtol`. Helper for
+ * `store_list`
+ */
+static argparse_error_t parse_int_element(argparse_arg_t *arg,
+                                          const char *start, const char *end,
+                                          int *out) {
+    const char *p = start;
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) {
+        p++;
+    }
+    if (p == end) {
+        return ARGPARSE_INVALID_VALUE_ERROR(
+            "argparse_parse_args: value in list for %s is not an integer\n",
+            arg->name_, arg->flag_);
+    }
+
+    // one past the magnitude of INT32_MIN, so the accumulator never overflows
+    const uint64_t limit = (uint64_t)INT32_MAX + 2;
+    // a leading zero selects octal or hexadecimal, as for `strtol`
+    bool decimal = *p != '0' || end - p == 1;
+    uint64_t res = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (decimal && end - p >= 8 && res < limit) {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        if (!ALL_DIGITS(w)) {
+            break;
+        }
+        res = res * 100000000 + parse_eight_digits(w);
+        p += 8;
+    }
+#endif
+    while (decimal && p < end && *p >= '0' && *p <= '9' && res < limit) {
+        res = res * 10 + (uint64_t)(*p++ - '0');
+    }
+
+    if (res < limit && p != end) {
+        // not a plain decimal number
+        errno = 0;
+        long value = strtol(start, NULL, 0);
+        if (errno == ERANGE || value > INT32_MAX || value < INT32_MIN) {
+            res = limit;
+        } else {
+            *out = (int)value;
+            return ARGPARSE_NO_ERROR();
+        }
+    }
+
+    if (res > (uint64_t)INT32_MAX + negative) {
+        return ARGPARSE_INT_RANGE_EXCEEDED_ERROR(
+            "argparse_parse_args: value in list for %s exceeds range of "
+            "integer\n",
+            arg->name_, arg->flag_);
+    }
+    *out = negative ? (int)(-(int64_t)res) : (int)res;
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Splits the string `value` on the delimiter of `arg` and stores the numbers
+ * in the argument's array. `arg_string` is reported as the offending argument
+ * on error. Helper for `get_and_update_value` and `bind_value`
+ */
+static argparse_error_t store_list(argument_parser_t *parser,
+                                   argparse_arg_t *arg, const char *value,
+                                   const char *arg_string) {
+    const char *end = value + strlen(value);
+    size_t n = 1;
+    for (const char *p = value;
+         (p = memchr(p, arg->delimiter_, (size_t)(end - p))); p++) {
+        n++;
+    }
+
+    char *array;
+    argparse_error_t error = values_array(parser, arg, n, arg_string, &array);
+    CHECK_ERROR(error);
+
+    const char *p = value;
+    for (size_t k = 0; k < n; k++) {
+        const char *next = memchr(p, arg->delimiter_, (size_t)(end - p));
+        if (next == NULL) {
+            next = end;
+        }
+        if (next == p) {
+            return ARGPARSE_INVALID_VALUE_ERROR(
+                "argparse_parse_args: empty value in list for %s\n",
+                arg->name_, arg->flag_);
+        }
+        if (arg->type_ == ARGPARSE_INT_TYPE) {
+            error = parse_int_element(arg, p, next, (int *)array + k);
+            CHECK_ERROR(error);
+            if (arg->bounds_) {
+                error = check_bounds(arg, ((int *)array)[k]);
+                CHECK_ERROR(error);
+            }
+        } else {
+            ((float *)array)[k] = strtof(p, NULL);
+            if (arg->bounds_) {
+                error = check_bounds(arg, ((float *)array)[k]);
+                CHECK_ERROR(error);
+            }
+        }
+        p = next + 1;
+    }
+
+    if (arg->capacity_ == 0) {
+        *(void **)value_ptr(parser, arg) = array;
+    }
+    arg->num_values_ = n;
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Stores the string `value` as the value of the latest occurrence of `arg`, an
+ * argument with the append action, in its buffer. `arg_string` is reported as
+ * the offending argument on error. Helper for `get_and_update_value` and
+ * `bind_value`
+ */
+static argparse_error_t append_value(argument_parser_t *parser,
+                                     argparse_arg_t *arg, const char *value,
+                                     const char *arg_string) {
+    if ((size_t)arg->count_ > arg->capacity_) {
+        arg->count_--;
+        return ARGPARSE_CAPACITY_EXCEEDED_ERROR(
+            "argparse_parse_args: too many occurrences of %s\n", arg_string);
+    }
+    size_t offset = (size_t)(arg->count_ - 1) * type_size(arg->type_);
+    return store_value(parser, arg, (char *)value_ptr(parser, arg) + offset,
+                       (void *)value, true);
+}
+
+/*
+ * Converts the string `token` to the type of `arg`, storing it at the value of
+ * the argument if it has one, and passes it to the argument's callback.
+ * `arg_string` is reported as the offending argument if the callback fails.
+ * Helper for `get_and_update_value` and `bind_value`
+ */
+static argparse_error_t invoke_callback(argument_parser_t *parser,
+                                        argparse_arg_t *arg, const char *token,
+                                        const char *arg_string) {
+    union {
+        int int_;
+        float float_;
+        const char *string_;
+        int64_t int64_;
+        uint64_t uint64_;
+    } tmp;
+    void *dest = value_ptr(parser, arg);
+    argparse_error_t error =
+        store_value(parser, arg, dest ? dest : &tmp, (void *)token, true);
+    CHECK_ERROR(error);
+
+    int status = arg->callback_(arg, token, dest ? dest : &tmp, arg->context_);
+    if (status != 0) {
+        return ARGPARSE_CALLBACK_ERROR(
+            "argparse_parse_args: callback for %s failed with status %d\n",
+            arg_string, status);
+    }
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Checks if the string `value` can be a value of `arg` rather than an option,
+ * which holds unless it starts with '-' and is not a negative number of a
+ * numeric argument
+ */
+static bool is_value(argparse_arg_t *arg, const char *value) {
+    if (value[0] != '-') {
+        return true;
+    }
+    bool numeric = arg->type_ == ARGPARSE_INT_TYPE ||
+                   arg->type_ == ARGPARSE_FLOAT_TYPE || IS_WIDE_INT(arg->type_);
+    return numeric &&
+           ((value[1] >= '0' && value[1] <= '9') || value[1] == '.');
+}
+
+/*
+ * Binds the string `value` to `arg` without converting it, for conversion by
+ * the `argparse_get_*` accessors in lazy mode. Helper for
+ * `get_and_update_value` and `bind_value`
+ */
+static argparse_error_t bind_raw(argument_parser_t *parser,
+                                 argparse_arg_t *arg, const char *value) {
+    if (parser->copy_strings_) {
+        value = argparse_arena_strdup(parser, value);
+        if (value == NULL) {
+            return ARGPARSE_OUT_OF_MEMORY_ERROR(
+                "argparse_parse_args: out of memory copying value of %s\n",
+                arg->name_ ? arg->name_ : "argument");
+        }
+    }
+    arg->raw_ = value;
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Gets the values for an argument with `nargs_` from `argv` and stores them in
+ * the argument's array. Once `options_ended` is set by a '--', every argument
+ * is a value, even if it starts with '-'. Advances the index `i` in the
+ * parsing function past the values. Helper for `get_and_update_value`
+ */
+static argparse_error_t get_and_update_values(argument_parser_t *parser,
+                                              argparse_arg_t *arg, int *i,
+                                              bool positional,
+                                              bool options_ended) {
+    int start = positional ? *i : *i + 1;
+    if (arg->nargs_ == REMAINDER) {
+        // the tail of argv is the array, so nothing is copied
+        *(char ***)value_ptr(parser, arg) = parser->argv_ + start;
+        arg->num_values_ = (size_t)(parser->argc_ - start);
+        *i = parser->argc_ - 1;
+        return ARGPARSE_NO_ERROR();
+    }
+
+    int end = start;
+    while (end < parser->argc_ &&
+           (arg->nargs_ < 0 || end - start < arg->nargs_) &&
+           (options_ended || is_value(arg, parser->argv_[end]))) {
+        end++;
+    }
+
+    size_t n = (size_t)(end - start);
+    if ((arg->nargs_ > 0 && n != (size_t)arg->nargs_) ||
+        (arg->nargs_ == ONE_OR_MORE && n == 0)) {
+        return ARGPARSE_ARGUMENT_MISSING_VALUE_ERROR(parser->argv_[*i], 0);
+    }
+
+    const char *arg_string = parser->argv_[*i];
+    *i = end - 1;
+    return store_values(parser, arg, parser->argv_ + start, n, arg_string);
+}
+
+/*
+ * Gets the value for the corresponding argument from `argv` and updates the
+ * the `value_` field of that argument. The value of an option is `attached` if
+ * it is not NULL, pointing into the option's own string, and is otherwise the
+ * next string, in which case the index `i` in the parsing function is advanced.
+ * `options_ended` is set once a '--' has been parsed. Helper for
+ * `argparse_parse_args`
+ */
+static argparse_error_t get_and_update_value(argument_parser_t *parser,
+                                             argparse_arg_t *arg, int *i,
+                                             bool positional,
+                                             bool options_ended, bool negated,
+                                             const char *attached) {
+    argparse_error_t error = touch_arg(parser, arg);
+    CHECK_ERROR(error);
+    arg->count_++;
+    MARK_PRESENT(parser, arg);
+    bool tmp_bool;
+    void *value = NULL;
+    const char *arg_string = parser->argv_[*i];
+
+    if (attached && !TAKES_VALUE(arg)) {
+        return ARGPARSE_UNEXPECTED_VALUE_ERROR(
+            "argparse_parse_args: option %s does not take a value\n",
+            arg_string);
+    }
+
+    switch (arg->action_) {
+    case ARGPARSE_STORE_ACTION:
+    case ARGPARSE_APPEND_ACTION:
+    case ARGPARSE_CALLBACK_ACTION: {
+        if (arg->nargs_ && attached) {
+            // an attached value is the only value of the occurrence
+            if (arg->nargs_ > 1) {
+                return ARGPARSE_ARGUMENT_MISSING_VALUE_ERROR(arg_string, 0);
+            }
+            return store_values(parser, arg, (char *const *)&attached, 1,
+                                arg_string);
+        }
+        if (arg->nargs_) {
+            return get_and_update_values(parser, arg, i, positional,
+                                         options_ended);
+        }
+        if (attached) {
+            value = (void *)attached;
+        } else if (positional) {
+            value = (void *)arg_string;
+        } else if (*i + 1 == parser->argc_) {
+            return ARGPARSE_ARGUMENT_MISSING_VALUE_ERROR(arg_string, 0);
+        } else {
+            value = (void *)parser->argv_[++(*i)];
+        }
+
+        if (arg->delimiter_) {
+            return store_list(parser, arg, value, arg_string);
+        }
+        if (IS_LAZY(parser, arg)) {
+            return bind_raw(parser, arg, value);
+        }
+
+        error = check_choices(arg, value, arg_string);
+        CHECK_ERROR(error);
+        if (arg->action_ == ARGPARSE_APPEND_ACTION) {
+            return append_value(parser, arg, value, arg_string);
+        }
+        if (arg->action_ == ARGPARSE_CALLBACK_ACTION) {
+            return invoke_callback(parser, arg, value, arg_string);
+        }
+        break;
+    }
+
+    case ARGPARSE_STORE_TRUE_ACTION:
+        tmp_bool = true;
+        value = &tmp_bool;
+        break;
+
+    case ARGPARSE_STORE_FALSE_ACTION:
+        tmp_bool = false;
+        value = &tmp_bool;
+        break;
+
+    case ARGPARSE_BOOLEAN_OPTIONAL_ACTION:
+        tmp_bool = !negated;
+        value = &tmp_bool;
+        break;
+
+    case ARGPARSE_COUNT_ACTION:
+        // count will be set when argument is finalised
+        return ARGPARSE_NO_ERROR();
+
+    default:
+        fprintf(stderr, "get_and_update_value: should not ever get here\n");
+        exit(EXIT_FAILURE);
+    }
+
+    error = update_value(parser, arg, value,
+                         arg->action_ == ARGPARSE_STORE_ACTION);
+    CHECK_ERROR(error);
+
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Looks up the argument named by `key`, which is either the long name of an
+ * option, with or without the leading `--`, or the name of a positional
+ * argument. Used when binding values by name rather than by position in argv
+ */
+static argparse_arg_t *find_arg_by_key(argument_parser_t *parser,
+                                       const char *key) {
+    if (starts_with(key, "-")) {
+        return find_arg(parser->options_, (arg_to_find){.tag = NAME_TO_FIND,
+                                                        .prefix = NULL,
+                                                        .u.name = key});
+    }
+
+    argparse_arg_t *arg =
+        find_arg(parser->options_, (arg_to_find){.tag = NAME_TO_FIND,
+                                                 .prefix = "--",
+                                                 .u.name = key});
+    if (arg == NULL) {
+        arg = find_arg(parser->positional_args_,
+                       (arg_to_find){.tag = NAME_TO_FIND,
+                                     .prefix = NULL,
+                                     .u.name = key});
+    }
+    return arg;
+}
+
+/*
+ * Finds the argument named by `name`, which is an option's flag such as `-t`,
+ * its long name with or without the leading `--`, or the name of a positional
+ * argument
+ */
+static argparse_arg_t *find_arg_by_name(argument_parser_t *parser,
+                                        const char *name) {
+    if (strlen(name) == 2 && name[0] == '-') {
+        return find_arg(parser->options_, (arg_to_find){.tag = FLAG_TO_FIND,
+                                                        .prefix = NULL,
+                                                        .u.flag = name[1]});
+    }
+    return find_arg_by_key(parser, name);
+}
+
+/*
+ * Finds the argument named by `name` for an accessor of type `type`, converts
+ * a value bound in lazy mode and stores the location of the value at `value`.
+ * Helper for the `argparse_get_*` accessors
+ */
+static argparse_error_t get_value(argument_parser_t *parser, const char *name,
+                                  argparse_type_t type, void **value) {
+    argparse_arg_t *arg = find_arg_by_name(parser, name);
+    if (arg == NULL) {
+        return ARGPARSE_ARGUMENT_UNKNOWN_ERROR(name);
+    }
+    // enums are read as ints, and sizes and durations as unsigned 64 bits
+    argparse_type_t arg_type = arg->type_;
+    if (arg_type == ARGPARSE_ENUM_TYPE) {
+        arg_type = ARGPARSE_INT_TYPE;
+    } else if (arg_type == ARGPARSE_SIZE_TYPE ||
+               arg_type == ARGPARSE_DURATION_TYPE) {
+        arg_type = ARGPARSE_UINT64_TYPE;
+    }
+    if (arg_type != type || IS_ARRAY(arg)) {
+        return ARGPARSE_TYPE_MISMATCH_ERROR(
+            "argparse_get: accessor does not match type of %s\n", name);
+    }
+    // a callback need not have a destination for its values
+    if (value_ptr(parser, arg) == NULL) {
+        return ARGPARSE_TYPE_MISMATCH_ERROR(
+            "argparse_get: %s does not store a value\n", name);
+    }
+
+    if (arg->raw_) {
+        argparse_error_t error = check_choices(arg, arg->raw_, name);
+        CHECK_ERROR(error);
+        error = update_value(parser, arg, (void *)arg->raw_, true);
+        CHECK_ERROR(error);
+        arg->raw_ = NULL;
+    }
+    *value = value_ptr(parser, arg);
+    return ARGPARSE_NO_ERROR();
+}
+
+argparse_error_t argparse_get_int(argument_parser_t *parser, const char *name,
+                                  int *out) {
+    void *value;
+    argparse_error_t error = get_value(parser, name, ARGPARSE_INT_TYPE, &value);
+    CHECK_ERROR(error);
+    *out = *(int *)value;
+    return ARGPARSE_NO_ERROR();
+}
+
+argparse_error_t argparse_get_float(argument_parser_t *parser,
+                                    const char *name, float *out) {
+    void *value;
+    argparse_error_t error =
+        get_value(parser, name, ARGPARSE_FLOAT_TYPE, &value);
+    CHECK_ERROR(error);
+    *out = *(float *)value;
+    return ARGPARSE_NO_ERROR();
+}
+
+argparse_error_t argparse_get_int64(argument_parser_t *parser,
+                                    const char *name, int64_t *out) {
+    void *value;
+    argparse_error_t error =
+        get_value(parser, name, ARGPARSE_INT64_TYPE, &value);
+    CHECK_ERROR(error);
+    *out = *(int64_t *)value;
+    return ARGPARSE_NO_ERROR();
+}
+
+argparse_error_t argparse_get_uint32(argument_parser_t *parser,
+                                     const char *name, uint32_t *out) {
+    void *value;
+    argparse_error_t error =
+        get_value(parser, name, ARGPARSE_UINT32_TYPE, &value);
+    CHECK_ERROR(error);
+    *out = *(uint32_t *)value;
+    return ARGPARSE_NO_ERROR();
+}
+
+argparse_error_t argparse_get_uint64(argument_parser_t *parser,
+                                     const char *name, uint64_t *out) {
+    void *value;
+    argparse_error_t error =
+        get_value(parser, name, ARGPARSE_UINT64_TYPE, &value);
+    CHECK_ERROR(error);
+    *out = *(uint64_t *)value;
+    return ARGPARSE_NO_ERROR();
+}
+
+argparse_error_t argparse_get_bool(argument_parser_t *parser, const char *name,
+                                   bool *out) {
+    void *value;
+    argparse_error_t error =
+        get_value(parser, name, ARGPARSE_BOOL_TYPE, &value);
+    CHECK_ERROR(error);
+    *out = *(bool *)value;
+    return ARGPARSE_NO_ERROR();
+}
+
+argparse_error_t argparse_get_string(argument_parser_t *parser,
+                                     const char *name, const char **out) {
+    void *value;
+    argparse_error_t error =
+        get_value(parser, name, ARGPARSE_STRING_TYPE, &value);
+    CHECK_ERROR(error);
+    *out = *(const char **)value;
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Produces the error for a value of the wrong kind in a JSON line or in a
+ * config file. Used by `bind_value`
+ */
+#define BIND_VALUE_ERROR(json, expected, key)                                  \
+    ((json) ? ARGPARSE_INVALID_JSON_ERROR("argparse_parse_json_line: "         \
+                                          "expected " expected " for %s\n",    \
+                                          (key))                               \
+            : ARGPARSE_INVALID_CONFIG_ERROR("argparse_parse_args: "            \
+                                            "expected " expected " for %s\n",  \
+                                            (key)))
+
+/*
+ * Binds the textual `value` given for `key` to `arg`, applying the same checks
+ * and conversions as parsing from the command line. `boolean` is 1 or 0 if the
+ * value spells true or false, and -1 otherwise. `json` selects how malformed
+ * values are reported. Helper for `argparse_parse_json_line` and
+ * `apply_config_file`
+ */
+static argparse_error_t bind_value(argument_parser_t *parser,
+                                   argparse_arg_t *arg, const char *key,
+                                   const char *value, int boolean, bool json) {
+    argparse_error_t error = touch_arg(parser, arg);
+    CHECK_ERROR(error);
+    bool tmp_bool;
+
+    switch (arg->action_) {
+    case ARGPARSE_STORE_ACTION:
+    case ARGPARSE_APPEND_ACTION:
+    case ARGPARSE_CALLBACK_ACTION: {
+        arg->count_++;
+        MARK_PRESENT(parser, arg);
+        if (arg->action_ == ARGPARSE_APPEND_ACTION) {
+            error = check_choices(arg, value, key);
+            CHECK_ERROR(error);
+            return append_value(parser, arg, value, key);
+        }
+        if (arg->action_ == ARGPARSE_CALLBACK_ACTION) {
+            error = check_choices(arg, value, key);
+            CHECK_ERROR(error);
+            return invoke_callback(parser, arg, value, key);
+        }
+        if (arg->nargs_) {
+            // a remainder is only ever a view of argv, which is terminated
+            if (arg->nargs_ == REMAINDER) {
+                return BIND_VALUE_ERROR(json, "command line arguments", key);
+            }
+            // a single value binds as an array of one value
+            if (arg->nargs_ > 1) {
+                return BIND_VALUE_ERROR(json, "multiple values", key);
+            }
+            return store_values(parser, arg, (char *const *)&value, 1, key);
+        }
+        if (arg->delimiter_) {
+            return store_list(parser, arg, value, key);
+        }
+        if (IS_LAZY(parser, arg)) {
+            return bind_raw(parser, arg, value);
+        }
+        error = check_choices(arg, value, key);
+        CHECK_ERROR(error);
+        return update_value(parser, arg, (void *)value, true);
+    }
+
+    case ARGPARSE_STORE_TRUE_ACTION:
+    case ARGPARSE_STORE_FALSE_ACTION:
+    case ARGPARSE_BOOLEAN_OPTIONAL_ACTION:
+        if (boolean == -1) {
+            return BIND_VALUE_ERROR(json, "true or false", key);
+        }
+        if (arg->action_ != ARGPARSE_BOOLEAN_OPTIONAL_ACTION) {
+            // a false flag is simply not present
+            if (boolean == 0) {
+                return ARGPARSE_NO_ERROR();
+            }
+            tmp_bool = arg->action_ == ARGPARSE_STORE_TRUE_ACTION;
+        } else {
+            tmp_bool = boolean;
+        }
+        arg->count_++;
+        MARK_PRESENT(parser, arg);
+        return update_value(parser, arg, &tmp_bool, false);
+
+    case ARGPARSE_COUNT_ACTION: {
+        char *end;
+        errno = 0;
+        long res = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || res < 0) {
+            return BIND_VALUE_ERROR(json, "non-negative integer", key);
+        }
+        if (errno == ERANGE || res > INT32_MAX - arg->count_) {
+            return ARGPARSE_INT_RANGE_EXCEEDED_ERROR(
+                "argparse_parse_args: count for %s exceeds range of integer\n",
+                key, 0);
+        }
+        // count will be set when argument is finalised
+        arg->count_ += (int)res;
+        if (res) {
+            MARK_PRESENT(parser, arg);
+        }
+        return ARGPARSE_NO_ERROR();
+    }
+
+    default:
+        fprintf(stderr, "bind_value: should not ever get here\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+ * Records the value of every environment variable in the parser's index with
+ * a single pass over `environ`, rather than calling `getenv` once per
+ * argument. Names are hashed as they are scanned up to the '='
+ */
+static void scan_environ(argument_parser_t *parser) {
+    if (parser->num_env_args_ == 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < parser->env_index_size_; i++) {
+        parser->env_index_[i].value_ = NULL;
+    }
+
+    size_t mask = parser->env_index_size_ - 1;
+    for (char **env = environ; *env; env++) {
+        const char *entry = *env;
+        uint64_t hash = FNV_OFFSET;
+        size_t len = 0;
+        while (entry[len] && entry[len] != '=') {
+            hash = (hash ^ (unsigned char)entry[len++]) * FNV_PRIME;
+        }
+        if (entry[len] != '=') {
+            continue;
+        }
+
+        for (size_t j = hash & mask; parser->env_index_[j].arg_;
+             j = (j + 1) & mask) {
+            argparse_env_slot_t *slot = &parser->env_index_[j];
+            if (strncmp(slot->arg_->env_, entry, len) == 0 &&
+                slot->arg_->env_[len] == '\0') {
+                slot->value_ = entry + len + 1;
+                break;
+            }
+        }
+    }
+}
+
+/*
+ * Returns the value of the environment variable declared by `arg`, as found
+ * by the last `scan_environ`, or NULL if it is unset or not declared
+ */
+static const char *env_value(argument_parser_t *parser, argparse_arg_t *arg) {
+    if (arg->env_ == NULL || parser->num_env_args_ == 0) {
+        return NULL;
+    }
+    return find_env_slot(parser, arg->env_, strlen(arg->env_))->value_;
+}
+
+/*
+ * Parses `value` as a boolean word, returning 1 for `true`, `yes`, `on` or
+ * `1`, 0 for their opposites and -1 otherwise. Used for values from config
+ * files and environment variables
+ */
+static int parse_boolean_word(const char *value) {
+    const char *truthy[] = {"true", "yes", "on", "1"};
+    const char *falsy[] = {"false", "no", "off", "0"};
+    for (size_t i = 0; i < 4; i++) {
+        if (strcmp(value, truthy[i]) == 0) {
+            return 1;
+        }
+        if (strcmp(value, falsy[i]) == 0) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Rule between the arguments of a parser, over bitsets of `num_words` words
+ * stored in `bits`. An exclusive group allows at most one of the arguments in
+ * its first bitset, and exactly one if it is required. A dependency requires
+ * each argument of its second bitset if an argument of its first is given
+ */
+struct argparse_rule {
+    struct argparse_rule *next;
+    enum { EXCLUSIVE_RULE, REQUIRES_RULE } kind;
+    bool required;
+    size_t num_words;
+    uint64_t bits[];
+};
+
+/*
+ * Returns the index of the lowest set bit of the non-zero word `word`
+ */
+static size_t lowest_bit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (size_t)__builtin_ctzll(word);
+#else
+    size_t i = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+/*
+ * Sets the bits of the `num_names` arguments named in `names` in `bits`.
+ * Helper for `add_rule`
+ */
+static argparse_error_t set_name_bits(argument_parser_t *parser,
+                                      const char *const *names,
+                                      size_t num_names, uint64_t *bits) {
+    for (size_t i = 0; i < num_names; i++) {
+        argparse_arg_t *arg = find_arg_by_name(parser, names[i]);
+        if (arg == NULL) {
+            return ARGPARSE_ARGUMENT_UNKNOWN_ERROR(names[i]);
+        }
+        bits[arg->bit_ / 64] |= BIT_MASK(arg->bit_);
+    }
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Adds a rule of `kind` over the arguments named in `first` and `second` to
+ * the parser. Helper for `argparse_add_exclusive_group` and
+ * `argparse_add_requires`
+ */
+static argparse_error_t add_rule(argument_parser_t *parser, int kind,
+                                 bool required, const char *const *first,
+                                 size_t num_first, const char *const *second,
+                                 size_t num_second) {
+    size_t words = parser->bit_words_;
+    struct argparse_rule *rule = argparse_arena_alloc(
+        parser, sizeof(*rule) + 2 * words * sizeof(*rule->bits));
+    if (rule == NULL) {
+        return ARGPARSE_OUT_OF_MEMORY_ERROR(
+            kind == EXCLUSIVE_RULE
+                ? "argparse_add_exclusive_group: out of memory adding %s\n"
+                : "argparse_add_requires: out of memory adding %s\n",
+            num_first && first[0] ? first[0] : "rule");
+    }
+    rule->kind = kind;
+    rule->required = required;
+    rule->num_words = words;
+    memset(rule->bits, 0, 2 * words * sizeof(*rule->bits));
+
+    argparse_error_t error =
+        set_name_bits(parser, first, num_first, rule->bits);
+    CHECK_ERROR(error);
+    error = set_name_bits(parser, second, num_second, rule->bits + words);
+    CHECK_ERROR(error);
+
+    rule->next = parser->rules_;
+    parser->rules_ = rule;
+    return ARGPARSE_NO_ERROR();
+}
+
+argparse_error_t argparse_add_exclusive_group(argument_parser_t *parser,
+                                              const char *const *names,
+                                              size_t num_names, bool required) {
+    return add_rule(parser, EXCLUSIVE_RULE, required, names, num_names, NULL,
+                    0);
+}
+
+argparse_error_t argparse_add_requires(argument_parser_t *parser,
+                                       const char *name,
+                                       const char *const *names,
+                                       size_t num_names) {
+    return add_rule(parser, REQUIRES_RULE, false, &name, 1, names, num_names);
+}
+
+/*
+ * Checks the rule against the parser's bitset of present arguments, a word at
+ * a time. Helper for `finalise_args`
+ */
+static argparse_error_t check_rule(argument_parser_t *parser,
+                                   const struct argparse_rule *rule) {
+    const uint64_t *first = rule->bits, *second = rule->bits + rule->num_words;
+    bool given = false;
+    for (size_t w = 0; w < rule->num_words; w++) {
+        uint64_t present = first[w] & parser->present_[w];
+        if (present == 0) {
+            continue;
+        }
+        if (rule->kind == EXCLUSIVE_RULE &&
+            (given || (present & (present - 1)))) {
+            // report the second argument given
+            uint64_t second_given = given ? present : present & (present - 1);
+            argparse_arg_t *arg =
+                parser->bit_args_[64 * w + lowest_bit(second_given)];
+            return ARGPARSE_CONFLICTING_OPTIONS_ERROR(
+                "argparse_parse_args: %s not allowed with another argument of "
+                "its group\n",
+                arg->name_, arg->flag_);
+        }
+        given = true;
+    }
+
+    for (size_t w = 0; w < rule->num_words; w++) {
+        uint64_t missing = 0;
+        if (rule->kind == EXCLUSIVE_RULE && !given && rule->required) {
+            missing = first[w];
+        } else if (rule->kind == REQUIRES_RULE && given) {
+            missing = second[w] & ~parser->present_[w];
+        }
+        if (missing) {
+            argparse_arg_t *arg =
+                parser->bit_args_[64 * w + lowest_bit(missing)];
+            return ARGPARSE_MISSING_ARGUMENT_ERROR(arg->name_, arg->flag_);
+        }
+    }
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Finalises the arguments added to the parser, after binding the environment
+ * to those still missing. Counts are stored, and required arguments and rules
+ * are checked, with word-wide operations on the bitsets of arguments, so
+ * only arguments given, counted or declaring environment variables are
+ * visited. Helper for `argparse_parse_args` and `argparse_parse_json_line`
+ */
+static argparse_error_t finalise_args(argument_parser_t *parser) {
+    argparse_error_t error;
+    for (size_t i = 0; i < parser->env_index_size_; i++) {
+        argparse_env_slot_t *slot = &parser->env_index_[i];
+        if (slot->arg_ && slot->value_ && slot->arg_->count_ == 0) {
+            error = bind_value(parser, slot->arg_, slot->arg_->env_,
+                               slot->value_, parse_boolean_word(slot->value_),
+                               false);
+            CHECK_ERROR(error);
+        }
+    }
+
+    for (size_t w = 0; w < parser->bit_words_; w++) {
+        for (uint64_t bits = parser->count_bits_[w]; bits;
+             bits &= bits - 1) {
+            argparse_arg_t *arg =
+                parser->bit_args_[64 * w + lowest_bit(bits)];
+            // only a count which changes the value is stored, and so touched,
+            // keeping counts that were not given out of the touched log
+            int stored;
+            memcpy(&stored, value_ptr(parser, arg), sizeof(stored));
+            if (arg->count_ != stored) {
+                error = update_value(parser, arg, &arg->count_, false);
+                CHECK_ERROR(error);
             }
-            break;
-        case NAME_TO_FIND:
-            if (arg.prefix) {
-                if (starts_with(curr_arg->name_, arg.prefix) &&
-                    strcmp(arg.u.name, curr_arg->name_ + strlen(arg.prefix)) ==
-                        0) {
-                    return curr_arg;
+        }
+
+        uint64_t missing = parser->required_bits_[w] & ~parser->present_[w];
+        if (missing) {
+            argparse_arg_t *arg =
+                parser->bit_args_[64 * w + lowest_bit(missing)];
+            return ARGPARSE_MISSING_ARGUMENT_ERROR(arg->name_, arg->flag_);
+        }
+    }
+
+    for (struct argparse_rule *rule = parser->rules_; rule; rule = rule->next) {
+        error = check_rule(parser, rule);
+        CHECK_ERROR(error);
+    }
+    finalise_flag_sets(parser);
+
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Maximum nesting depth of response files, which also bounds the stack used
+ * for cycle detection
+ */
+#define MAX_RESPONSE_FILE_DEPTH 32
+
+/*
+ * Splits the `size` bytes at `data` into whitespace-separated tokens in place.
+ * Quotes and backslashes are decoded and the tokens are packed back-to-back at
+ * the start of `data`, each followed by a NUL. Decoding never lengthens a
+ * token, so at most one byte past `size` is written. Returns the number of
+ * tokens
+ */
+static size_t tokenize_in_place(char *data, size_t size) {
+    char *r = data, *end = data + size, *w = data;
+    size_t num_tokens = 0;
+
+    while (r < end) {
+        if (*r == ' ' || *r == '\t' || *r == '\n' || *r == '\r' ||
+            *r == '\v' || *r == '\f') {
+            r++;
+            continue;
+        }
+
+        char quote = '\0';
+        while (r < end) {
+            char c = *r++;
+            if (quote == '\'') {
+                if (c == '\'') {
+                    quote = '\0';
+                } else {
+                    *w++ = c;
                 }
-            } else {
-                if (strcmp(arg.u.name, curr_arg->name_) == 0) {
-                    return curr_arg;
+            } else if (c == '\\' && r < end &&
+                       (quote == '\0' || *r == '"' || *r == '\\')) {
+                *w++ = *r++;
+            } else if (quote == '"') {
+                if (c == '"') {
+                    quote = '\0';
+                } else {
+                    *w++ = c;
                 }
+            } else if (c == '\'' || c == '"') {
+                quote = c;
+            } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+                       c == '\v' || c == '\f') {
+                break;
+            } else {
+                *w++ = c;
             }
-            break;
-        case INDEX_TO_FIND:
-            if (arg.u.index == i) {
-                return curr_arg;
+        }
+        *w++ = '\0';
+        num_tokens++;
+    }
+
+    return num_tokens;
+}
+
+/*
+ * Suffix appended to the path of a response file to name its token cache
+ */
+#define TOKEN_CACHE_SUFFIX ".argcache"
+
+/*
+ * Magic bytes identifying a token cache, including a format version
+ */
+#define TOKEN_CACHE_MAGIC "ARGPTOK1"
+
+/*
+ * Header of a token cache. It is followed by the path of the response file
+ * (padded to 8 bytes), the offset of each token and then the packed tokens
+ */
+typedef struct {
+    char magic[8];
+    uint64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t hash;
+    uint64_t path_len;
+    uint64_t num_tokens;
+    uint64_t tokens_size;
+} token_cache_header;
+
+/*
+ * Rounds `n` up to a multiple of 8 so the token offsets stay aligned
+ */
+#define ALIGN8(n) (((n) + 7) & ~(size_t)7)
+
+/*
+ * Hashes the contents of a response file eight bytes at a time
+ */
+static uint64_t hash_contents(const char *data, size_t size) {
+    uint64_t hash = 0x9E3779B97F4A7C15ULL ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t w;
+        memcpy(&w, data + i, 8);
+        hash = (hash ^ w) * 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 32;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ (unsigned char)data[i]) * FNV_PRIME;
+    }
+    return hash ^ hash >> 29;
+}
+
+/*
+ * Builds the header describing the response file `path` with status `st`
+ */
+static token_cache_header cache_header(const char *path, const struct stat *st,
+                                       uint64_t hash) {
+    token_cache_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TOKEN_CACHE_MAGIC, sizeof(header.magic));
+    header.size = (uint64_t)st->st_size;
+    header.mtime_sec = (int64_t)st->st_mtim.tv_sec;
+    header.mtime_nsec = (int64_t)st->st_mtim.tv_nsec;
+    header.hash = hash;
+    header.path_len = strlen(path);
+    return header;
+}
+
+/*
+ * Returns the path of the token cache for `path`, allocated with `malloc`
+ */
+static char *cache_path(const char *path) {
+    size_t len = strlen(path);
+    char *res = malloc(len + sizeof(TOKEN_CACHE_SUFFIX));
+    if (res) {
+        memcpy(res, path, len);
+        memcpy(res + len, TOKEN_CACHE_SUFFIX, sizeof(TOKEN_CACHE_SUFFIX));
+    }
+    return res;
+}
+
+/*
+ * Maps the token cache of the response file `path` if it matches the file
+ * open as `fd`, filling in `mapping`. Only a regular file owned by the
+ * effective user and writable by no one else is trusted, as its tokens are
+ * used without reading the response file again. Returns false if there is no
+ * usable cache, in which case the file should be tokenised
+ */
+static bool load_token_cache(const char *path, int fd, const struct stat *st,
+                             argparse_mapping_t *mapping) {
+    char *cache = cache_path(path);
+    if (cache == NULL) {
+        return false;
+    }
+    int cache_fd = open(cache, O_RDONLY | O_NOFOLLOW);
+    free(cache);
+    if (cache_fd < 0) {
+        return false;
+    }
+
+    struct stat cache_st;
+    char *data = MAP_FAILED;
+    if (fstat(cache_fd, &cache_st) == 0 && S_ISREG(cache_st.st_mode) &&
+        cache_st.st_uid == geteuid() &&
+        (cache_st.st_mode & (S_IWGRP | S_IWOTH)) == 0 &&
+        (size_t)cache_st.st_size >= sizeof(token_cache_header)) {
+        data = mmap(NULL, (size_t)cache_st.st_size, PROT_READ, MAP_PRIVATE,
+                    cache_fd, 0);
+    }
+    close(cache_fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    // compare everything but the hash first, which requires reading the file
+    token_cache_header header;
+    memcpy(&header, data, sizeof(header));
+    token_cache_header expected = cache_header(path, st, header.hash);
+    size_t size = (size_t)cache_st.st_size;
+    size_t path_end = sizeof(header) + ALIGN8(header.path_len);
+    bool valid =
+        memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 &&
+        header.size == expected.size &&
+        header.mtime_sec == expected.mtime_sec &&
+        header.mtime_nsec == expected.mtime_nsec &&
+        header.path_len == expected.path_len && path_end <= size &&
+        memcmp(data + sizeof(header), path, header.path_len) == 0 &&
+        header.num_tokens <= (size - path_end) / sizeof(uint64_t) &&
+        header.tokens_size ==
+            size - path_end - header.num_tokens * sizeof(uint64_t);
+
+    if (valid && header.size) {
+        char *contents =
+            mmap(NULL, (size_t)header.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        valid = contents != MAP_FAILED &&
+                hash_contents(contents, (size_t)header.size) == header.hash;
+        if (contents != MAP_FAILED) {
+            munmap(contents, (size_t)header.size);
+        }
+    }
+
+    // reject corrupt caches whose tokens would be read out of bounds
+    const uint64_t *offsets = (const uint64_t *)(data + path_end);
+    char *tokens = data + path_end + header.num_tokens * sizeof(uint64_t);
+    valid = valid && (header.num_tokens == 0 ||
+                      (header.tokens_size &&
+                       tokens[header.tokens_size - 1] == '\0'));
+    for (size_t t = 0; valid && t < header.num_tokens; t++) {
+        valid = offsets[t] < header.tokens_size;
+    }
+    if (!valid) {
+        munmap(data, size);
+        return false;
+    }
+
+    mapping->data_ = data;
+    mapping->size_ = size;
+    mapping->offsets_ = offsets;
+    mapping->tokens_ = tokens;
+    mapping->num_tokens_ = (size_t)header.num_tokens;
+    return true;
+}
+
+/*
+ * Writes the tokens of `mapping` to the token cache of the response file
+ * `path`. The cache is written to a temporary file which is then renamed, so
+ * concurrent parsers never observe a partial cache. The temporary file is
+ * created by `mkstemp` with an unpredictable name and mode 0600, so a link
+ * planted in a shared directory is never followed. Failures are ignored, as
+ * the file will simply be tokenised again next time
+ */
+static void save_token_cache(const char *path, const struct stat *st,
+                             uint64_t hash, const argparse_mapping_t *mapping) {
+    char *cache = cache_path(path);
+    if (cache == NULL) {
+        return;
+    }
+    size_t cache_len = strlen(cache);
+    char *tmp = malloc(cache_len + 32);
+    if (tmp == NULL) {
+        free(cache);
+        return;
+    }
+    snprintf(tmp, cache_len + 32, "%s.XXXXXX", cache);
+
+    token_cache_header header = cache_header(path, st, hash);
+    const char *end = mapping->tokens_;
+    uint64_t *offsets = malloc(mapping->num_tokens_ * sizeof(*offsets) + 1);
+    int fd = offsets ? mkstemp(tmp) : -1;
+    FILE *file = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (fd >= 0 && file == NULL) {
+        close(fd);
+    }
+    bool ok = file != NULL;
+    if (ok) {
+        for (size_t t = 0; t < mapping->num_tokens_; t++) {
+            offsets[t] = (uint64_t)(end - mapping->tokens_);
+            end += strlen(end) + 1;
+        }
+        header.num_tokens = mapping->num_tokens_;
+        header.tokens_size = (uint64_t)(end - mapping->tokens_);
+
+        static const char padding[8] = {0};
+        ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(path, 1, header.path_len, file) == header.path_len &&
+             fwrite(padding, 1, ALIGN8(header.path_len) - header.path_len,
+                    file) == ALIGN8(header.path_len) - header.path_len &&
+             fwrite(offsets, sizeof(*offsets), mapping->num_tokens_, file) ==
+                 mapping->num_tokens_ &&
+             fwrite(mapping->tokens_, 1, header.tokens_size, file) ==
+                 header.tokens_size;
+        ok = fclose(file) == 0 && ok;
+    }
+    if (ok) {
+        ok = rename(tmp, cache) == 0;
+    }
+    if (!ok && fd >= 0) {
+        unlink(tmp);
+    }
+
+    free(offsets);
+    free(tmp);
+    free(cache);
+}
+
+/*
+ * Maps the `size` bytes of the file open as `fd` privately into memory. The
+ * mapping reserves one byte past the end of the file, backed by anonymous
+ * memory where the file ends on a page boundary, so the contents can always be
+ * NUL-terminated in place. Returns MAP_FAILED on failure
+ */
+static char *map_private(int fd, size_t size) {
+    char *data = mmap(NULL, size + 1, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data != MAP_FAILED &&
+        mmap(data, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd,
+             0) == MAP_FAILED) {
+        munmap(data, size + 1);
+        data = MAP_FAILED;
+    }
+    return data;
+}
+
+/*
+ * Maps the file at `path` privately into memory without tokenising it, for
+ * reading the config file. `mapping->data_` is NULL for an empty file
+ */
+static argparse_error_t map_file(const char *path,
+                                 argparse_mapping_t *mapping) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return ARGPARSE_FILE_ERROR(
+            "argparse_parse_args: cannot open config file %s\n", path);
+    }
+
+    char *data = st.st_size ? map_private(fd, (size_t)st.st_size) : NULL;
+    close(fd);
+    if (data == MAP_FAILED) {
+        return ARGPARSE_FILE_ERROR(
+            "argparse_parse_args: cannot map config file %s\n", path);
+    }
+
+    mapping->data_ = data;
+    mapping->size_ = data ? (size_t)st.st_size + 1 : 0;
+    mapping->tokens_ = NULL;
+    mapping->num_tokens_ = 0;
+    mapping->offsets_ = NULL;
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Maps the response file at `path` privately into memory and tokenises it,
+ * or maps its token cache instead when `cache` is set and the cache is valid.
+ * The file's identity is returned through `st`
+ */
+static argparse_error_t map_response_file(const char *path, bool cache,
+                                          argparse_mapping_t *mapping,
+                                          struct stat *st) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return ARGPARSE_FILE_ERROR(
+            "argparse_parse_args: cannot open response file %s\n", path);
+    }
+    if (fstat(fd, st) != 0) {
+        close(fd);
+        return ARGPARSE_FILE_ERROR(
+            "argparse_parse_args: cannot read response file %s\n", path);
+    }
+
+    mapping->data_ = NULL;
+    mapping->size_ = 0;
+    mapping->tokens_ = NULL;
+    mapping->num_tokens_ = 0;
+    mapping->offsets_ = NULL;
+    if (st->st_size == 0 ||
+        (cache && load_token_cache(path, fd, st, mapping))) {
+        close(fd);
+        return ARGPARSE_NO_ERROR();
+    }
+
+    size_t size = (size_t)st->st_size;
+    char *data = map_private(fd, size);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return ARGPARSE_FILE_ERROR(
+            "argparse_parse_args: cannot map response file %s\n", path);
+    }
+
+    uint64_t hash = cache ? hash_contents(data, size) : 0;
+    mapping->data_ = data;
+    mapping->size_ = size + 1;
+    mapping->tokens_ = data;
+    mapping->num_tokens_ = tokenize_in_place(data, size);
+    if (cache) {
+        save_token_cache(path, st, hash, mapping);
+    }
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Identity of a response file being expanded, used to detect cycles
+ */
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+} file_id;
+
+/*
+ * Expands the tokens of `mapping`, or the `argc` elements of `argv` if
+ * `mapping` is NULL. Runs in two phases: when `out` is NULL, response files
+ * are mapped in depth-first order and the expanded tokens are only counted in
+ * `*n`; otherwise the mappings are revisited in the same order through
+ * `*next_mapping` and the tokens are written to `out`. Helper for
+ * `expand_response_files`
+ */
+static argparse_error_t expand_tokens(argument_parser_t *parser, char **argv,
+                                      int argc,
+                                      const argparse_mapping_t *mapping,
+                                      char **out, size_t *n,
+                                      size_t *next_mapping, file_id *stack,
+                                      size_t depth) {
+    // the mappings array may move when nested files are mapped, so only the
+    // fields of `mapping` are kept rather than the pointer
+    size_t num_tokens = mapping ? mapping->num_tokens_ : (size_t)argc;
+    char *tokens = mapping ? mapping->tokens_ : NULL;
+    const uint64_t *offsets = mapping ? mapping->offsets_ : NULL;
+    char *packed_token = tokens;
+    for (size_t t = 0; t < num_tokens; t++) {
+        char *token;
+        if (mapping == NULL) {
+            token = argv[t];
+        } else if (offsets) {
+            token = tokens + offsets[t];
+        } else {
+            token = packed_token;
+            packed_token += strlen(packed_token) + 1;
+        }
+
+        if (token[0] == '\0' ||
+            strchr(parser->fromfile_prefix_chars_, token[0]) == NULL) {
+            if (out) {
+                out[*n] = token;
             }
-            break;
-        default:
-            fprintf(stderr, "find_arg: should not ever get here\n");
-            exit(EXIT_FAILURE);
+            (*n)++;
+            continue;
         }
 
-        curr_arg = curr_arg->next_;
-        i++;
+        const char *path = token + 1;
+        size_t index;
+        if (out) {
+            index = (*next_mapping)++;
+        } else {
+            if (depth == MAX_RESPONSE_FILE_DEPTH) {
+                return ARGPARSE_FILE_ERROR(
+                    "argparse_parse_args: response files nested too deeply at "
+                    "%s\n",
+                    path);
+            }
+
+            argparse_mapping_t *mappings =
+                realloc(parser->mappings_,
+                        (parser->num_mappings_ + 1) * sizeof(*mappings));
+            if (mappings == NULL) {
+                return ARGPARSE_OUT_OF_MEMORY_ERROR(
+                    "argparse_parse_args: out of memory expanding %s\n", path);
+            }
+            parser->mappings_ = mappings;
+            index = parser->num_mappings_;
+
+            struct stat st;
+            argparse_error_t error = map_response_file(
+                path, parser->token_cache_, &parser->mappings_[index], &st);
+            CHECK_ERROR(error);
+            parser->num_mappings_++;
+
+            for (size_t k = 0; k < depth; k++) {
+                if (stack[k].dev == st.st_dev && stack[k].ino == st.st_ino) {
+                    return ARGPARSE_FILE_ERROR(
+                        "argparse_parse_args: response file %s includes "
+                        "itself\n",
+                        path);
+                }
+            }
+            stack[depth] = (file_id){st.st_dev, st.st_ino};
+        }
+
+        argparse_error_t error =
+            expand_tokens(parser, NULL, 0, &parser->mappings_[index], out, n,
+                          next_mapping, stack, depth + 1);
+        CHECK_ERROR(error);
+    }
+
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Replaces the argument vector of the parser with one where every response
+ * file argument is substituted by the tokens of that file. The tokens are not
+ * copied: the new vector points into the original vector and the mappings,
+ * and is allocated once. Helper for `argparse_parse_args`
+ */
+static argparse_error_t expand_response_files(argument_parser_t *parser) {
+    bool found = false;
+    for (int i = 0; i < parser->argc_ && !found; i++) {
+        found = parser->argv_[i][0] != '\0' &&
+                strchr(parser->fromfile_prefix_chars_, parser->argv_[i][0]);
+    }
+    if (!found) {
+        return ARGPARSE_NO_ERROR();
+    }
+
+    file_id stack[MAX_RESPONSE_FILE_DEPTH];
+    size_t n = 0, next_mapping = parser->num_mappings_;
+    argparse_error_t error = expand_tokens(parser, parser->argv_, parser->argc_,
+                                           NULL, NULL, &n, NULL, stack, 0);
+    CHECK_ERROR(error);
+    if (n > INT_MAX) {
+        return ARGPARSE_FILE_ERROR(
+            "argparse_parse_args: too many arguments in response files\n",
+            NULL);
+    }
+
+    char **argv = malloc((n + 1) * sizeof(*argv));
+    if (argv == NULL) {
+        return ARGPARSE_OUT_OF_MEMORY_ERROR(
+            "argparse_parse_args: out of memory expanding response files\n",
+            NULL);
+    }
+    n = 0;
+    error = expand_tokens(parser, parser->argv_, parser->argc_, NULL, argv, &n,
+                          &next_mapping, NULL, 0);
+    CHECK_ERROR(error);
+    argv[n] = NULL;
+
+    parser->expanded_argv_ = argv;
+    parser->unexpanded_argv_ = parser->argv_;
+    parser->unexpanded_argc_ = parser->argc_;
+    parser->argv_ = argv;
+    parser->argc_ = (int)n;
+    return ARGPARSE_NO_ERROR();
+}
+
+/*
+ * Checks if `c` is whitespace within a line of a config file
+ */
+#define IS_CONFIG_SPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\r')
+
+/*
+ * Checks if the argument collects a value from each occurrence rather than
+ * keeping the last one
+ */
+#define ACCUMULATES(arg)                                                       \
+    ((arg)->action_ == ARGPARSE_APPEND_ACTION ||                               \
+     (arg)->action_ == ARGPARSE_CALLBACK_ACTION ||                             \
+     (arg)->type_ == ARGPARSE_DICT_TYPE)
+
+/*
+ * A line of a config file whose value is bound once the other lines are
+ */
+typedef struct {
+    argparse_arg_t *arg;
+    const char *key;
+    const char *value;
+    size_t line_num;
+} config_line;
+
+/*
+ * Parses one line of a config file, between `start` and `end`, and binds its
+ * value unless the argument was already given. The value of an argument which
+ * accumulates values is returned in `deferred` instead, to be bound in file
+ * order. The key and value are NUL-terminated in place, which never writes
+ * before `start` or after `end`. Helper for `apply_config_file`
+ */
+static argparse_error_t apply_config_line(argument_parser_t *parser,
+                                          char *start, char *end,
+                                          config_line *deferred) {
+    while (start < end && IS_CONFIG_SPACE(*start)) {
+        start++;
+    }
+    while (end > start && IS_CONFIG_SPACE(end[-1])) {
+        end--;
+    }
+
+    // skip blank lines, comments and section headers
+    if (start == end || *start == '#' || *start == ';' || *start == '[') {
+        return ARGPARSE_NO_ERROR();
+    }
+
+    char *equals = memchr(start, '=', end - start);
+    if (equals == NULL || equals == start) {
+        return ARGPARSE_INVALID_CONFIG_ERROR(
+            "argparse_parse_args: expected 'name = value' in config file\n",
+            NULL);
+    }
+
+    char *key_end = equals;
+    while (IS_CONFIG_SPACE(key_end[-1])) {
+        key_end--;
+    }
+    char *value = equals + 1;
+    while (value < end && IS_CONFIG_SPACE(*value)) {
+        value++;
+    }
+    if (end - value >= 2 && (*value == '"' || *value == '\'') &&
+        end[-1] == *value) {
+        value++;
+        end--;
+    }
+    *key_end = '\0';
+    *end = '\0';
+
+    const char *key = start;
+    argparse_arg_t *arg = find_arg_by_key(parser, key);
+    if (arg == NULL) {
+        return ARGPARSE_ARGUMENT_UNKNOWN_ERROR(key);
+    }
+
+    // arguments given on the command line or in the environment, or later in
+    // the file, take precedence. A false flag or a zero count on a later line
+    // leaves the count at 0, but still touches the argument. Accumulating
+    // arguments are only bound after this pass, so they are touched here only
+    // if given on the command line
+    if (arg->touched_ || env_value(parser, arg)) {
+        return ARGPARSE_NO_ERROR();
+    }
+    if (ACCUMULATES(arg)) {
+        deferred->arg = arg;
+        deferred->key = key;
+        deferred->value = value;
+        return ARGPARSE_NO_ERROR();
     }
 
-    return NULL;
+    return bind_value(parser, arg, key, value, parse_boolean_word(value),
+                      false);
 }
 
 /*
- * Updates the memory location pointed to by `arg->value_` with `value`.
- * Performs type-cast based on `arg->type_`. Helper for `get_and_update_value`
+ * Maps the config file named by the parser and binds each `name = value`
+ * line to the argument with that name, after the command line has been
+ * parsed. Lines are applied from last to first, so that skipping arguments
+ * which were already touched gives the command line precedence over the file
+ * and later lines precedence over earlier ones, without a second pass. The
+ * lines of accumulating arguments are collected instead, and bound in file
+ * order afterwards. Errors report the file and line. Helper for
+ * `argparse_parse_args`
  */
-static argparse_error_t update_value(argparse_arg_t *arg, void *value,
-                                     bool string) {
-    switch (arg->type_) {
-    case ARGPARSE_INT_TYPE: {
-        errno = 0;
-        long res;
-        res = string ? strtol(value, NULL, 0) : *(int *)value;
-        if (errno == ERANGE || res > INT32_MAX || res < INT32_MIN) {
-            return ARGPARSE_INT_RANGE_EXCEEDED_ERROR(
-                "argparse_parse_args: value for %s exceeds range of integer\n",
-                arg->name_, arg->flag_);
-        }
-        *(int *)arg->value_ = (int)res;
-        break;
+static argparse_error_t apply_config_file(argument_parser_t *parser) {
+    const char *path = parser->config_file_;
+    argparse_mapping_t *mappings = realloc(
+        parser->mappings_, (parser->num_mappings_ + 1) * sizeof(*mappings));
+    if (mappings == NULL) {
+        return ARGPARSE_OUT_OF_MEMORY_ERROR(
+            "argparse_parse_args: out of memory reading config file %s\n",
+            path);
     }
-    case ARGPARSE_FLOAT_TYPE:
-        *(float *)arg->value_ = string ? strtof(value, NULL) : *(float *)value;
-        break;
-    case ARGPARSE_BOOL_TYPE:
-        *(bool *)arg->value_ = *(bool *)value;
-        break;
-    case ARGPARSE_STRING_TYPE:
-        *(const char **)arg->value_ = value;
-        break;
-    default:
-        fprintf(stderr, "argparse_parse_args: should not ever get here\n");
-        exit(EXIT_FAILURE);
+    parser->mappings_ = mappings;
+
+    argparse_mapping_t *mapping = &parser->mappings_[parser->num_mappings_];
+    argparse_error_t error = map_file(path, mapping);
+    CHECK_ERROR(error);
+    parser->num_mappings_++;
+
+    char *data = mapping->data_;
+    if (data == NULL) {
+        return ARGPARSE_NO_ERROR();
     }
-    return ARGPARSE_NO_ERROR();
-}
 
-/*
- * Gets the value for the corresponding argument from `argv` and updates the
- * the `value_` field of that argument. Advances the index `i` in the parsing
- * function if the argument is positional. Helper for `argparse_parse_args`
- */
-static argparse_error_t get_and_update_value(argument_parser_t *parser,
-                                             argparse_arg_t *arg, int *i,
-                                             bool positional, bool negated) {
-    arg->count_++;
-    bool tmp_bool = arg->num_choices_ == 0;
-    void *value = NULL;
+    size_t size = mapping->size_ - 1;
+    size_t line_num = 1;
+    for (char *c = data; (c = memchr(c, '\n', data + size - c)); c++) {
+        line_num++;
+    }
 
-    switch (arg->action_) {
-    case ARGPARSE_STORE_ACTION:
-        if (!positional && *i + 1 == parser->argc_) {
-            return ARGPARSE_ARGUMENT_MISSING_VALUE_ERROR(parser->argv_[*i], 0);
+    config_line *deferred = NULL;
+    size_t num_deferred = 0, capacity = 0;
+    char *end = data + size;
+    for (;;) {
+        char *start = end;
+        while (start > data && start[-1] != '\n') {
+            start--;
         }
 
-        value = positional ? (void *)parser->argv_[*i]
-                           : (void *)parser->argv_[++(*i)];
-
-        // check if the value is in the choices
-        for (size_t j = 0; j < arg->num_choices_; j++) {
-            switch (arg->type_) {
-            case ARGPARSE_INT_TYPE:
-                errno = 0;
-                long res = strtol(value, NULL, 0);
-                if (errno == ERANGE || res > INT32_MAX || res < INT32_MIN) {
-                    return ARGPARSE_INT_RANGE_EXCEEDED_ERROR(
-                        "argparse_parse_args: choice for %s exceeds range of "
-                        "integer\n",
-                        arg->name_, arg->flag_);
-                }
-                tmp_bool = ((int *)arg->choices_)[j] == (int)res;
-                break;
-            case ARGPARSE_FLOAT_TYPE:
-                tmp_bool =
-                    WITHIN(strtof(value, NULL), ((float *)arg->choices_)[j]);
-                break;
-            case ARGPARSE_BOOL_TYPE:
-                // non-store actions and bool types do not support choices
-                break;
-            case ARGPARSE_STRING_TYPE:
-                tmp_bool = strcmp(((const char **)arg->choices_)[j],
-                                  (const char *)value) == 0;
-                break;
-            default:
-                fprintf(stderr, "should not get here\n");
-                exit(EXIT_FAILURE);
-            }
-            if (tmp_bool) {
-                break;
+        config_line line = {NULL, NULL, NULL, line_num};
+        error = apply_config_line(parser, start, end, &line);
+        if (error.error_val) {
+            break;
+        }
+        if (line.arg && num_deferred == capacity) {
+            capacity = capacity ? 2 * capacity : 8;
+            config_line *lines = realloc(deferred, capacity * sizeof(*lines));
+            if (lines == NULL) {
+                free(deferred);
+                return ARGPARSE_OUT_OF_MEMORY_ERROR(
+                    "argparse_parse_args: out of memory reading config file "
+                    "%s\n",
+                    path);
             }
+            deferred = lines;
         }
-        if (!tmp_bool) {
-            return ARGPARSE_INVALID_CHOICE_ERROR(
-                parser->argv_[*i - !positional], 0);
+        if (line.arg) {
+            deferred[num_deferred++] = line;
         }
 
-        break;
+        if (start == data) {
+            break;
+        }
+        end = start - 1;
+        line_num--;
+    }
 
-    case ARGPARSE_STORE_TRUE_ACTION:
-        tmp_bool = true;
-        value = &tmp_bool;
-        break;
+    // the deferred lines were collected from last to first
+    while (!error.error_val && num_deferred) {
+        config_line *line = &deferred[--num_deferred];
+        line_num = line->line_num;
+        error = bind_value(parser, line->arg, line->key, line->value,
+                           parse_boolean_word(line->value), false);
+    }
+    free(deferred);
+    if (error.error_val) {
+        error.file_name = path;
+        error.line_num = line_num;
+    }
+    return error;
+}
 
-    case ARGPARSE_STORE_FALSE_ACTION:
-        tmp_bool = false;
-        value = &tmp_bool;
-        break;
+/*
+ * Stores the index `i` of an unknown token in `unknown`, which holds
+ * `capacity` indices of which `*num_unknown` are used. Helper for
+ * `parse_args`
+ */
+static argparse_error_t add_unknown(argument_parser_t *parser, int i,
+                                    int *unknown, size_t capacity,
+                                    size_t *num_unknown) {
+    if (*num_unknown == capacity) {
+        return ARGPARSE_CAPACITY_EXCEEDED_ERROR(
+            "argparse_parse_known_args: too many unknown arguments at %s\n",
+            parser->argv_[i]);
+    }
+    unknown[(*num_unknown)++] = i;
+    return ARGPARSE_NO_ERROR();
+}
 
-    case ARGPARSE_BOOLEAN_OPTIONAL_ACTION:
-        tmp_bool = !negated;
-        value = &tmp_bool;
-        break;
+static argparse_error_t parse_args(argument_parser_t *parser, int *unknown,
+                                   size_t capacity, size_t *num_unknown);
 
-    case ARGPARSE_COUNT_ACTION:
-        // count will be set when argument is finalised
-        return ARGPARSE_NO_ERROR();
+/*
+ * Selects the subcommand named by the argument at index `i` and parses the
+ * arguments after it with a new parser holding the subcommand's arguments.
+ * Unknown arguments are collected as for `parse_args`, with indices into the
+ * argument vector of `parser`. Helper for `parse_args`
+ */
+static argparse_error_t parse_subcommand(argument_parser_t *parser, int i,
+                                         int *unknown, size_t capacity,
+                                         size_t *num_unknown) {
+    const char *name = parser->argv_[i];
+    argparse_subcommand_t *subcommand = *find_subcommand_slot(parser, name);
+    if (subcommand == NULL) {
+        return ARGPARSE_INVALID_CHOICE_ERROR(name, 0);
+    }
 
-    default:
-        fprintf(stderr, "get_and_update_value: should not ever get here\n");
-        exit(EXIT_FAILURE);
+    free_subparser(parser);
+    argument_parser_t *sub = malloc(sizeof(*sub));
+    if (sub == NULL) {
+        return ARGPARSE_OUT_OF_MEMORY_ERROR(
+            "argparse_parse_args: out of memory creating parser for %s\n",
+            name);
     }
+    argparse_init(sub, parser->argc_ - i, parser->argv_ + i,
+                  subcommand->help_, NO_EPILOG);
+    sub->lazy_ = parser->lazy_;
+    sub->copy_strings_ = parser->copy_strings_;
+    sub->struct_ = parser->struct_;
+    sub->struct_size_ = parser->struct_size_;
+    parser->subcommand_ = subcommand;
+    parser->subparser_ = sub;
 
-    argparse_error_t error =
-        update_value(arg, value, arg->action_ == ARGPARSE_STORE_ACTION);
+    // the usage message names the program as well as the subcommand
+    size_t len = strlen(parser->prog_) + strlen(name) + 2;
+    char *prog = argparse_arena_alloc(sub, len);
+    if (prog == NULL) {
+        return ARGPARSE_OUT_OF_MEMORY_ERROR(
+            "argparse_parse_args: out of memory creating parser for %s\n",
+            name);
+    }
+    snprintf(prog, len, "%s %s", parser->prog_, name);
+    sub->prog_ = prog;
+
+    argparse_error_t error = subcommand->init_(sub, subcommand->context_);
     CHECK_ERROR(error);
 
-    return ARGPARSE_NO_ERROR();
+    if (unknown == NULL) {
+        return parse_args(sub, NULL, 0, NULL);
+    }
+    size_t start = *num_unknown, n = 0;
+    error = parse_args(sub, unknown + start, capacity - start, &n);
+    *num_unknown += n;
+    for (size_t k = start; k < *num_unknown; k++) {
+        unknown[k] += i + 1;
+    }
+    return error;
 }
 
 /*
- * Finalises the argument after all the arguments have been parsed. Values for
- * count actions are updated and missing arguments result in an error
+ * Parses the argument vector, then binds the environment and config file.
+ * Unknown tokens are an error if `unknown` is NULL, otherwise their indices
+ * are collected with those of the values following unknown options. Helper
+ * for `argparse_parse_args` and `argparse_parse_known_args`
  */
-static argparse_error_t finalise_arg(argparse_arg_t *arg) {
-    if (arg->action_ == ARGPARSE_COUNT_ACTION) {
-        return update_value(arg, &arg->count_, false);
-    }
-
-    if (arg->count_ == 0 && arg->required_) {
-        return ARGPARSE_MISSING_ARGUMENT_ERROR(arg->name_, arg->flag_);
+static argparse_error_t parse_args(argument_parser_t *parser, int *unknown,
+                                   size_t capacity, size_t *num_unknown) {
+    if (parser->fromfile_prefix_chars_ && parser->expanded_argv_ == NULL) {
+        argparse_error_t error = expand_response_files(parser);
+        CHECK_ERROR(error);
     }
 
-    return ARGPARSE_NO_ERROR();
-}
-
-argparse_error_t argparse_parse_args(argument_parser_t *parser) {
     size_t positional_i = 0;
+    bool options_ended = false;
     for (int i = 0; i < parser->argc_; i++) {
         const char *arg_string = parser->argv_[i];
         argparse_arg_t *arg = NULL;
         bool positional = false, negated = false;
-        if (strcmp(arg_string, "-h") == 0 ||
-            strcmp(arg_string, "--help") == 0) {
+        const char *attached = NULL;
+        if (!options_ended && strcmp(arg_string, "--") == 0) {
+            // everything after '--' is positional
+            options_ended = true;
+            continue;
+        }
+
+        if (!options_ended && (strcmp(arg_string, "-h") == 0 ||
+                               strcmp(arg_string, "--help") == 0)) {
             // display usage string
             argparse_print_help(parser);
             exit(EXIT_SUCCESS);
-        } else if (strlen(arg_string) == 2 && starts_with(arg_string, "-")) {
+        } else if (!options_ended && strlen(arg_string) == 2 &&
+                   starts_with(arg_string, "-")) {
             // option flag
             arg = find_arg(parser->options_,
                            (arg_to_find){.tag = FLAG_TO_FIND,
                                          .prefix = NULL,
                                          .u.flag = *(arg_string + 1)});
-        } else if (starts_with(arg_string, "-")) {
+        } else if (!options_ended && starts_with(arg_string, "-")) {
             if (starts_with(arg_string, "--no-")) {
                 // potential boolean optional
                 arg = find_arg(parser->options_,
@@ -636,8 +3996,27 @@ argparse_error_t argparse_parse_args(argument_parser_t *parser) {
                 negated = false;
             }
 
+            const char *equals = strchr(arg_string, '=');
+            if (arg == NULL && equals && starts_with(arg_string, "--")) {
+                // option name with the value attached after '='
+                arg = find_arg(parser->options_,
+                               (arg_to_find){.tag = NAME_TO_FIND,
+                                             .prefix = NULL,
+                                             .u.name = arg_string,
+                                             .len = equals - arg_string});
+                attached = arg ? equals + 1 : NULL;
+            }
+
+            if (arg == NULL && update_flag(parser, arg_string)) {
+                // feature flag
+                continue;
+            }
+
             if (arg == NULL) {
-                // grouped option flags
+                // grouped option flags, the last of which may take the rest
+                // of the string as its value. Every flag is resolved before
+                // any is applied, so a group with an unknown flag is left
+                // whole to the caller or a subcommand
                 size_t j = 1;
                 while (arg_string[j]) {
                     arg = find_arg(parser->options_,
@@ -647,14 +4026,43 @@ argparse_error_t argparse_parse_args(argument_parser_t *parser) {
                     if (arg == NULL) {
                         goto unknown;
                     }
-                    argparse_error_t error = get_and_update_value(
-                        parser, arg, &i, arg->action_ != ARGPARSE_STORE_ACTION,
-                        false);
-                    CHECK_ERROR(error);
                     j++;
+                    if (TAKES_VALUE(arg)) {
+                        break;
+                    }
+                }
+
+                j = 1;
+                while (arg_string[j]) {
+                    arg = find_arg(parser->options_,
+                                   (arg_to_find){.tag = FLAG_TO_FIND,
+                                                 .prefix = NULL,
+                                                 .u.flag = *(arg_string + j)});
+                    j++;
+                    attached = TAKES_VALUE(arg) && arg_string[j]
+                                   ? arg_string + j
+                                   : NULL;
+                    argparse_error_t error =
+                        get_and_update_value(parser, arg, &i, !TAKES_VALUE(arg),
+                                             false, false, attached);
+                    CHECK_ERROR(error);
+                    if (attached) {
+                        break;
+                    }
                 }
                 continue;
             }
+        } else if (parser->subcommands_ &&
+                   find_arg(parser->positional_args_,
+                            (arg_to_find){.tag = INDEX_TO_FIND,
+                                          .prefix = NULL,
+                                          .u.index = positional_i}) == NULL) {
+            // subcommand once the positional arguments are filled, which
+            // takes the rest of the arguments
+            argparse_error_t error =
+                parse_subcommand(parser, i, unknown, capacity, num_unknown);
+            CHECK_ERROR(error);
+            break;
         } else {
             // positional argument
             arg = find_arg(parser->positional_args_,
@@ -666,34 +4074,409 @@ argparse_error_t argparse_parse_args(argument_parser_t *parser) {
 
     unknown:
         if (arg == NULL) {
-            return ARGPARSE_ARGUMENT_UNKNOWN_ERROR(arg_string);
+            if (unknown == NULL) {
+                return ARGPARSE_ARGUMENT_UNKNOWN_ERROR(arg_string);
+            }
+            argparse_error_t error =
+                add_unknown(parser, i, unknown, capacity, num_unknown);
+            CHECK_ERROR(error);
+            if (positional || strchr(arg_string, '=')) {
+                continue;
+            }
+
+            // values of an unknown option without an attached value, unless a
+            // positional argument can take them
+            while (i + 1 < parser->argc_ && parser->argv_[i + 1][0] != '-' &&
+                   find_arg(parser->positional_args_,
+                            (arg_to_find){.tag = INDEX_TO_FIND,
+                                          .prefix = NULL,
+                                          .u.index = positional_i}) == NULL) {
+                error = add_unknown(parser, ++i, unknown, capacity,
+                                    num_unknown);
+                CHECK_ERROR(error);
+            }
+            continue;
         }
 
         argparse_error_t error =
-            get_and_update_value(parser, arg, &i, positional, negated);
+            get_and_update_value(parser, arg, &i, positional, options_ended,
+                                 negated, attached);
         CHECK_ERROR(error);
     }
 
-    // set default values for missing options and raise an error if any missing
-    // arguments are required
-    argparse_arg_t *args[] = {parser->options_, parser->positional_args_};
+    scan_environ(parser);
+    if (parser->config_file_) {
+        argparse_error_t error = apply_config_file(parser);
+        CHECK_ERROR(error);
+    }
+
+    return finalise_args(parser);
+}
+
+argparse_error_t argparse_parse_args(argument_parser_t *parser) {
+    return parse_args(parser, NULL, 0, NULL);
+}
+
+argparse_error_t argparse_parse_known_args(argument_parser_t *parser,
+                                           int *unknown, size_t capacity,
+                                           size_t *num_unknown) {
+    *num_unknown = 0;
+    return parse_args(parser, unknown, capacity, num_unknown);
+}
+
+/*
+ * Word-at-a-time helpers for the JSON scanner. `HAS_ZERO_BYTE(w)` is non-zero
+ * iff some byte of the 64-bit word `w` is zero, `HAS_BYTE(w, c)` iff some byte
+ * equals `c` and `HAS_LESS(w, n)` iff some byte is less than `n` (n <= 128)
+ */
+#define ONES_WORD ((uint64_t)0x0101010101010101ULL)
+#define HIGHS_WORD ((uint64_t)0x8080808080808080ULL)
+#define HAS_ZERO_BYTE(w) (((w) - ONES_WORD) & ~(w) & HIGHS_WORD)
+#define HAS_BYTE(w, c) HAS_ZERO_BYTE((w) ^ (ONES_WORD * (uint8_t)(c)))
+#define HAS_LESS(w, n) (((w) - ONES_WORD * (uint8_t)(n)) & ~(w) & HIGHS_WORD)
+
+/*
+ * Checks if `c` is JSON insignificant whitespace
+ */
+#define IS_JSON_SPACE(c)                                                       \
+    ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+/*
+ * Cursor over a single line of JSON. `pos` is advanced in place as tokens are
+ * consumed, and never moves past `end`
+ */
+typedef struct {
+    char *pos;
+    char *end;
+} json_scanner;
+
+/*
+ * Skips whitespace and returns the next character, or '\0' at end of input
+ */
+static char json_peek(json_scanner *scanner) {
+    while (scanner->pos < scanner->end && IS_JSON_SPACE(*scanner->pos)) {
+        scanner->pos++;
+    }
+    return scanner->pos < scanner->end ? *scanner->pos : '\0';
+}
+
+/*
+ * Reads four hex digits of a \u escape into `code`. Returns false if the
+ * digits are missing or malformed
+ */
+static bool json_hex4(json_scanner *scanner, unsigned *code) {
+    if (scanner->end - scanner->pos < 4) {
+        return false;
+    }
+    *code = 0;
+    for (int k = 0; k < 4; k++) {
+        char c = *scanner->pos++;
+        unsigned digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        *code = *code << 4 | digit;
+    }
+    return true;
+}
+
+/*
+ * Decodes the JSON string starting at the opening quote under the cursor.
+ * Escapes are decoded in place and the result is NUL-terminated over the
+ * closing quote, so the returned pointer aliases the input buffer. Plain runs
+ * of characters are skipped eight bytes at a time. Returns NULL if the string
+ * is malformed
+ */
+static char *json_string(json_scanner *scanner) {
+    char *start = ++scanner->pos;
+    char *out = start;
+
+    for (;;) {
+        // skip over bytes that need no decoding a word at a time
+        while (scanner->end - scanner->pos >= 8) {
+            uint64_t w;
+            memcpy(&w, scanner->pos, 8);
+            if (HAS_BYTE(w, '"') || HAS_BYTE(w, '\\') || HAS_LESS(w, 0x20)) {
+                break;
+            }
+            if (out != scanner->pos) {
+                memmove(out, scanner->pos, 8);
+            }
+            out += 8;
+            scanner->pos += 8;
+        }
+
+        if (scanner->pos == scanner->end) {
+            return NULL;
+        }
+
+        char c = *scanner->pos++;
+        if (c == '"') {
+            *out = '\0';
+            return start;
+        }
+        if ((unsigned char)c < 0x20) {
+            return NULL;
+        }
+        if (c != '\\') {
+            *out++ = c;
+            continue;
+        }
+
+        if (scanner->pos == scanner->end) {
+            return NULL;
+        }
+        switch (*scanner->pos++) {
+        case '"':
+            *out++ = '"';
+            break;
+        case '\\':
+            *out++ = '\\';
+            break;
+        case '/':
+            *out++ = '/';
+            break;
+        case 'b':
+            *out++ = '\b';
+            break;
+        case 'f':
+            *out++ = '\f';
+            break;
+        case 'n':
+            *out++ = '\n';
+            break;
+        case 'r':
+            *out++ = '\r';
+            break;
+        case 't':
+            *out++ = '\t';
+            break;
+        case 'u': {
+            unsigned code, low;
+            if (!json_hex4(scanner, &code)) {
+                return NULL;
+            }
+            if (code >= 0xD800 && code <= 0xDBFF) {
+                // high surrogate, must be followed by an escaped low surrogate
+                if (scanner->end - scanner->pos < 2 ||
+                    scanner->pos[0] != '\\' || scanner->pos[1] != 'u') {
+                    return NULL;
+                }
+                scanner->pos += 2;
+                if (!json_hex4(scanner, &low) || low < 0xDC00 ||
+                    low > 0xDFFF) {
+                    return NULL;
+                }
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                return NULL;
+            }
+
+            // the UTF-8 encoding is never longer than the escape sequence
+            if (code < 0x80) {
+                *out++ = (char)code;
+            } else if (code < 0x800) {
+                *out++ = (char)(0xC0 | code >> 6);
+                *out++ = (char)(0x80 | (code & 0x3F));
+            } else if (code < 0x10000) {
+                *out++ = (char)(0xE0 | code >> 12);
+                *out++ = (char)(0x80 | (code >> 6 & 0x3F));
+                *out++ = (char)(0x80 | (code & 0x3F));
+            } else {
+                *out++ = (char)(0xF0 | code >> 18);
+                *out++ = (char)(0x80 | (code >> 12 & 0x3F));
+                *out++ = (char)(0x80 | (code >> 6 & 0x3F));
+                *out++ = (char)(0x80 | (code & 0x3F));
+            }
+            break;
+        }
+        default:
+            return NULL;
+        }
+    }
+}
+
+/*
+ * Returns the number of decimal digits at the start of `s`. Helper for
+ * `is_json_number`
+ */
+static size_t count_digits(const char *s) {
+    size_t n = 0;
+    while (s[n] >= '0' && s[n] <= '9') {
+        n++;
+    }
+    return n;
+}
+
+/*
+ * Checks if the NUL-terminated `s` follows the JSON number grammar, which
+ * has no leading '+' or zeros, and digits on both sides of a '.'. Helper for
+ * `json_literal`
+ */
+static bool is_json_number(const char *s) {
+    s += *s == '-';
+    size_t n = count_digits(s);
+    if (n == 0 || (n > 1 && *s == '0')) {
+        return false;
+    }
+    s += n;
+    if (*s == '.') {
+        n = count_digits(++s);
+        if (n == 0) {
+            return false;
+        }
+        s += n;
+    }
+    if (*s == 'e' || *s == 'E') {
+        s++;
+        s += *s == '+' || *s == '-';
+        n = count_digits(s);
+        if (n == 0) {
+            return false;
+        }
+        s += n;
+    }
+    return *s == '\0';
+}
+
+/*
+ * Reads a bare JSON literal (number, `true`, `false` or `null`) under the
+ * cursor. The literal is NUL-terminated in place and the delimiter it
+ * overwrote is returned through `delim`. Returns NULL if there is no valid
+ * literal or no room to terminate it
+ */
+static char *json_literal(json_scanner *scanner, char *delim) {
+    char *start = scanner->pos;
+    while (scanner->pos < scanner->end && *scanner->pos != ',' &&
+           *scanner->pos != '}' && !IS_JSON_SPACE(*scanner->pos)) {
+        scanner->pos++;
+    }
+    if (scanner->pos == start || scanner->pos == scanner->end) {
+        return NULL;
+    }
+    *delim = *scanner->pos;
+    *scanner->pos++ = '\0';
+    if (strcmp(start, "true") != 0 && strcmp(start, "false") != 0 &&
+        strcmp(start, "null") != 0 && !is_json_number(start)) {
+        return NULL;
+    }
+    return start;
+}
+
+argparse_error_t argparse_parse_json_line(argument_parser_t *parser,
+                                          char *line, size_t len) {
+    json_scanner scanner = {line, line + len};
     argparse_error_t error;
-    for (size_t i = 0; i < 2; i++) {
-        argparse_arg_t *arg = args[i];
-        while (arg) {
-            error = finalise_arg(arg);
+
+    if (json_peek(&scanner) != '{') {
+        return ARGPARSE_INVALID_JSON_ERROR(
+            "argparse_parse_json_line: expected '{' at start of line\n", NULL);
+    }
+    scanner.pos++;
+
+    char next = json_peek(&scanner);
+    if (next == '}') {
+        scanner.pos++;
+    }
+
+    while (next != '}') {
+        if (next != '"') {
+            return ARGPARSE_INVALID_JSON_ERROR(
+                "argparse_parse_json_line: expected string key\n", NULL);
+        }
+        const char *key = json_string(&scanner);
+        if (key == NULL) {
+            return ARGPARSE_INVALID_JSON_ERROR(
+                "argparse_parse_json_line: malformed string key\n", NULL);
+        }
+        if (json_peek(&scanner) != ':') {
+            return ARGPARSE_INVALID_JSON_ERROR(
+                "argparse_parse_json_line: expected ':' after key %s\n", key);
+        }
+        scanner.pos++;
+
+        // a literal overwrites its delimiter, which is consumed here instead
+        const char *value;
+        bool string = json_peek(&scanner) == '"';
+        char delim = '\0';
+        if (string) {
+            value = json_string(&scanner);
+        } else if (*scanner.pos == '{' || *scanner.pos == '[') {
+            return ARGPARSE_INVALID_JSON_ERROR(
+                "argparse_parse_json_line: nested value for %s is not "
+                "supported\n",
+                key);
+        } else {
+            value = json_literal(&scanner, &delim);
+        }
+        if (value == NULL) {
+            return ARGPARSE_INVALID_JSON_ERROR(
+                "argparse_parse_json_line: malformed value for %s\n", key);
+        }
+
+        argparse_arg_t *arg = find_arg_by_key(parser, key);
+        if (arg == NULL) {
+            return ARGPARSE_ARGUMENT_UNKNOWN_ERROR(key);
+        }
+
+        // null leaves the argument as though it were absent from the line
+        if (string || strcmp(value, "null") != 0) {
+            int boolean = string                        ? -1
+                          : strcmp(value, "true") == 0  ? 1
+                          : strcmp(value, "false") == 0 ? 0
+                                                        : -1;
+            if (TAKES_VALUE(arg) && boolean != -1) {
+                return ARGPARSE_INVALID_JSON_ERROR(
+                    "argparse_parse_json_line: expected string or number for "
+                    "%s\n",
+                    key);
+            }
+            error = bind_value(parser, arg, key, value, boolean, true);
             CHECK_ERROR(error);
-            arg = arg->next_;
+        }
+
+        if (delim == '\0' || IS_JSON_SPACE(delim)) {
+            next = json_peek(&scanner);
+            scanner.pos += next != '\0';
+        } else {
+            next = delim;
+        }
+        if (next == ',') {
+            next = json_peek(&scanner);
+            if (next != '"') {
+                return ARGPARSE_INVALID_JSON_ERROR(
+                    "argparse_parse_json_line: expected key after ','\n",
+                    NULL);
+            }
+        } else if (next != '}') {
+            return ARGPARSE_INVALID_JSON_ERROR(
+                "argparse_parse_json_line: expected ',' or '}' after %s\n",
+                key);
         }
     }
 
-    return ARGPARSE_NO_ERROR();
+    if (json_peek(&scanner) != '\0') {
+        return ARGPARSE_INVALID_JSON_ERROR(
+            "argparse_parse_json_line: unexpected data after object\n", NULL);
+    }
+
+    scan_environ(parser);
+    return finalise_args(parser);
 }
 
 argparse_error_val argparse_check_error(argparse_error_t error) {
     if (error.error_val != ARGPARSE_NO_ERROR) {
         fprintf(stderr, "\n");
     }
+    if (error.file_name) {
+        fprintf(stderr, "%s:%zu: ", error.file_name, error.line_num);
+    }
     switch (error.error_val) {
     case ARGPARSE_NO_ERROR:
         break;
@@ -701,12 +4484,26 @@ argparse_error_val argparse_check_error(argparse_error_t error) {
     case ARGPARSE_UNSUPPORTED_ACTION_ERROR:
     case ARGPARSE_CONFLICTING_OPTIONS_ERROR:
     case ARGPARSE_INT_RANGE_EXCEEDED_ERROR:
+    case ARGPARSE_INVALID_JSON_ERROR:
+    case ARGPARSE_FILE_ERROR:
+    case ARGPARSE_INVALID_CONFIG_ERROR:
+    case ARGPARSE_OUT_OF_MEMORY_ERROR:
+    case ARGPARSE_INVALID_FIELD_ERROR:
+    case ARGPARSE_CAPACITY_EXCEEDED_ERROR:
+    case ARGPARSE_DUPLICATE_KEY_ERROR:
+    case ARGPARSE_TYPE_MISMATCH_ERROR:
+    case ARGPARSE_UNEXPECTED_VALUE_ERROR:
+    case ARGPARSE_OUT_OF_BOUNDS_ERROR:
+    case ARGPARSE_INVALID_VALUE_ERROR:
         if (error.arg_name || error.arg_flag) {
             fprintf(stderr, error.error_msg, FORMAT_FN_STRING(error));
         } else {
             fprintf(stderr, "%s", error.error_msg);
         }
         break;
+    case ARGPARSE_CALLBACK_ERROR:
+        fprintf(stderr, error.error_msg, error.arg_name, error.callback_status);
+        break;
     case ARGPARSE_INVALID_TYPE_ERROR:
         fprintf(stderr, "argparse_add_argument: %d is not a valid type\n",
                 error.arg_flag);
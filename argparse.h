@@ -34,6 +34,8 @@ extern "C" {
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
 /********************* STRUCTS AND ENUMS *********************/
 
@@ -70,14 +72,39 @@ typedef enum {
     /// value of argument does not match choices provided
     ARGPARSE_INVALID_CHOICE_ERROR = -11,
     /// argument is not provided on command line
-    ARGPARSE_MISSING_ARGUMENT_ERROR = -12
+    ARGPARSE_MISSING_ARGUMENT_ERROR = -12,
+    /// input line is not a flat JSON object of supported values
+    ARGPARSE_INVALID_JSON_ERROR = -13,
+    /// response file cannot be read, or includes itself
+    ARGPARSE_FILE_ERROR = -14,
+    /// config file line or environment variable value is malformed
+    ARGPARSE_INVALID_CONFIG_ERROR = -15,
+    /// memory could not be allocated
+    ARGPARSE_OUT_OF_MEMORY_ERROR = -16,
+    /// struct field of an argument does not fit its type or the bound struct
+    ARGPARSE_INVALID_FIELD_ERROR = -17,
+    /// more values are given than the buffer of the argument can hold
+    ARGPARSE_CAPACITY_EXCEEDED_ERROR = -18,
+    /// key is repeated in a dictionary that rejects duplicate keys
+    ARGPARSE_DUPLICATE_KEY_ERROR = -19,
+    /// typed accessor does not match the type of the argument
+    ARGPARSE_TYPE_MISMATCH_ERROR = -20,
+    /// callback of an argument returned a non-zero status
+    ARGPARSE_CALLBACK_ERROR = -21,
+    /// value attached to an option which does not take one
+    ARGPARSE_UNEXPECTED_VALUE_ERROR = -22,
+    /// value of a numeric argument lies outside its bounds
+    ARGPARSE_OUT_OF_BOUNDS_ERROR = -23,
+    /// value of a numeric argument is not a number
+    ARGPARSE_INVALID_VALUE_ERROR = -24
 } argparse_error_val;
 
 /**
  * @brief Struct representing an argparse error
  *
  * Contains information on the error code, the error message and the argument
- * causing the error.
+ * causing the error, as well as its location for errors in a config file and
+ * the status returned by a failing callback.
  */
 typedef struct {
     /// error code
@@ -88,6 +115,12 @@ typedef struct {
     const char *arg_name;
     /// flag of argument causing the error
     char arg_flag;
+    /// file containing the error (NULL if not from a config file)
+    const char *file_name;
+    /// line of `file_name` containing the error
+    size_t line_num;
+    /// non-zero status returned by a failing callback (0 for other errors)
+    int callback_status;
 } argparse_error_t;
 
 /**
@@ -103,7 +136,12 @@ typedef enum {
     /// count the occurrences of argument, must be int type
     ARGPARSE_COUNT_ACTION,
     /// boolean action, similar to a flag, must be bool type
-    ARGPARSE_BOOLEAN_OPTIONAL_ACTION
+    ARGPARSE_BOOLEAN_OPTIONAL_ACTION,
+    /// store the value of each occurrence in the array at `value_` holding
+    /// `capacity_` values, must be non-bool type
+    ARGPARSE_APPEND_ACTION,
+    /// convert the value and pass it to `callback_`, must be non-bool type
+    ARGPARSE_CALLBACK_ACTION
 } argparse_action_t;
 
 /**
@@ -117,9 +155,111 @@ typedef enum {
     /// boolean argument type, value should be `bool`
     ARGPARSE_BOOL_TYPE,
     /// string argument type, value should be `const char *`
-    ARGPARSE_STRING_TYPE
+    ARGPARSE_STRING_TYPE,
+    /// dictionary argument type of `key=value` pairs, value should be
+    /// `argparse_dict_t`
+    ARGPARSE_DICT_TYPE,
+    /// enumeration argument type, value should be `int`, set to the index of
+    /// the string in `choices_` matching the value
+    ARGPARSE_ENUM_TYPE,
+    /// 64-bit integer argument type, value should be `int64_t`
+    ARGPARSE_INT64_TYPE,
+    /// unsigned 32-bit integer argument type, value should be `uint32_t`
+    ARGPARSE_UINT32_TYPE,
+    /// unsigned 64-bit integer argument type, value should be `uint64_t`
+    ARGPARSE_UINT64_TYPE,
+    /// size argument type with a unit such as `512MiB` or `10k`, value should
+    /// be `uint64_t`, set to the number of bytes
+    ARGPARSE_SIZE_TYPE,
+    /// duration argument type with a unit such as `250ms` or `2h`, value
+    /// should be `uint64_t`, set to the number of nanoseconds
+    ARGPARSE_DURATION_TYPE
 } argparse_type_t;
 
+/**
+ * @brief Enum representing how a dictionary handles a repeated key
+ */
+typedef enum {
+    /// the value of the last occurrence of the key is kept
+    ARGPARSE_DICT_LAST_WINS,
+    /// the value of the first occurrence of the key is kept
+    ARGPARSE_DICT_FIRST_WINS,
+    /// a repeated key is an error
+    ARGPARSE_DICT_REJECT
+} argparse_dict_policy_t;
+
+/**
+ * @brief Struct representing a `key=value` pair of a dictionary
+ *
+ * The key and value are slices of the argument they were given in, so the key
+ * is not NUL-terminated.
+ */
+typedef struct {
+    /// start of the key
+    const char *key_;
+    /// length of the key
+    size_t key_len_;
+    /// NUL-terminated value following the first '='
+    const char *value_;
+    /// hash of the key
+    uint64_t hash_;
+} argparse_dict_entry_t;
+
+/**
+ * @brief Struct representing a dictionary of `key=value` pairs
+ *
+ * Pairs are kept in insertion order in `entries_`, indexed by an
+ * open-addressing hash table allocated from the parser's arena. When the table
+ * grows, the arrays it replaces stay in the arena until `argparse_free`. A
+ * dictionary should be zero-initialised, apart from `policy_`.
+ */
+typedef struct {
+    /// how a repeated key is handled
+    argparse_dict_policy_t policy_;
+    /// pairs in the order their keys were first given
+    argparse_dict_entry_t *entries_;
+    /// number of pairs in `entries_`
+    size_t num_entries_;
+    /// hash table of indices into `entries_` plus one, indexed by key
+    uint32_t *slots_;
+    /// number of slots in `slots_`, zero or a power of two
+    size_t num_slots_;
+} argparse_dict_t;
+
+/**
+ * @brief Bounds checked against the values of a numeric argument, as a
+ * combination of flags
+ */
+typedef enum {
+    /// no bounds
+    ARGPARSE_NO_BOUNDS = 0,
+    /// values must be at least `min_`
+    ARGPARSE_MIN_INCLUSIVE = 1 << 0,
+    /// values must be greater than `min_`
+    ARGPARSE_MIN_EXCLUSIVE = 1 << 1,
+    /// values must be at most `max_`
+    ARGPARSE_MAX_INCLUSIVE = 1 << 2,
+    /// values must be less than `max_`
+    ARGPARSE_MAX_EXCLUSIVE = 1 << 3
+} argparse_bounds_t;
+
+struct argparse_arg_t;
+
+/**
+ * @brief Function invoked with each value of an argument with the callback
+ * action
+ *
+ * @param arg Pointer to the argument
+ * @param token Value as given, before conversion
+ * @param value Pointer to the converted value, of the argument's type
+ * @param context User context of the argument
+ * @return Zero on success, or a non-zero status to stop parsing with
+ * `ARGPARSE_CALLBACK_ERROR`, which carries the status in `callback_status`
+ */
+typedef int (*argparse_callback_t)(struct argparse_arg_t *arg,
+                                   const char *token, const void *value,
+                                   void *context);
+
 /**
  * @brief Struct representing an individual argument
  *
@@ -152,8 +292,182 @@ typedef struct argparse_arg_t {
     void *choices_;
     /// number of valid choices choices provided in the array
     size_t num_choices_;
+    /// environment variable supplying the value if absent (NULL if none)
+    const char *env_;
+    /// offset of the value within the parser's bound struct
+    size_t offset_;
+    /// size of the struct field holding the value (0 if stored at `value_`)
+    size_t size_;
+    /// number of values taken per occurrence, `ONE_OR_MORE`, `ZERO_OR_MORE`
+    /// or `REMAINDER`
+    /// (0 for a single value not stored in an array)
+    int nargs_;
+    /// number of values the array at `value_` holds (0 if the array is
+    /// allocated from the parser's arena and its address stored at `value_`)
+    size_t capacity_;
+    /// character separating the values of a list in a single value, for int
+    /// and float types ('\0' if the value is not a list)
+    char delimiter_;
+    /// function invoked with each value for the callback action
+    argparse_callback_t callback_;
+    /// user context passed to `callback_`
+    void *context_;
+    /// bounds checked against each value as it is converted, a combination
+    /// of `argparse_bounds_t` flags
+    unsigned bounds_;
+    /// lower bound of the values, compared exactly against integer values of
+    /// any width
+    double min_;
+    /// upper bound of the values
+    double max_;
+
+    /** Parser state */
+    /// whether the argument is linked into a parser, until that parser is freed
+    bool added_;
+    /// whether the argument has been touched since the parser was last reset
+    bool touched_;
+    /// number of values in the array of an argument with `nargs_`
+    size_t num_values_;
+    /// value bound but not yet converted in lazy mode (NULL if none)
+    const char *raw_;
+    /// index of the bit of the argument in the parser's bitsets
+    size_t bit_;
+    /// perfect hash of the choices of an enum argument, allocated from the
+    /// parser's arena (NULL for other types)
+    struct argparse_enum_index *enum_index_;
+    /// array allocated from the parser's arena for the values of an argument
+    /// without a buffer, reused by later occurrences and parses
+    void *arena_array_;
+    /// number of values `arena_array_` holds
+    size_t arena_capacity_;
 } argparse_arg_t;
 
+/**
+ * @brief Struct representing a set of boolean feature flags stored as bits
+ *
+ * Each name in the set is enabled by `enable_prefix_` followed by the name and
+ * disabled by `disable_prefix_` followed by the name. Flag `i` is stored in bit
+ * `i % 64` of word `i / 64` of `bits_`.
+ */
+typedef struct argparse_flag_set_t {
+    /** User-provided information */
+    /// names of the flags, indexed by bit
+    const char *const *names_;
+    /// number of flags in the set
+    size_t num_flags_;
+    /// words receiving the flags, `ARGPARSE_FLAG_WORDS(num_flags_)` long
+    uint64_t *bits_;
+    /// default words of the flags (NULL if all flags default to clear)
+    const uint64_t *defaults_;
+    /// prefix enabling a flag (NULL for `--enable-`)
+    const char *enable_prefix_;
+    /// prefix disabling a flag (NULL for `--no-`)
+    const char *disable_prefix_;
+    /// help description for the set
+    const char *help_;
+
+    /** Parser state */
+    /// pointer to the next flag set, for linked list
+    struct argparse_flag_set_t *next_;
+    /// open-addressing hash table of flag indices plus one, indexed by name
+    uint32_t *index_;
+    /// number of slots in `index_`, a power of two
+    size_t index_size_;
+    /// words of flags enabled by the parse
+    uint64_t *set_;
+    /// words of flags disabled by the parse
+    uint64_t *clear_;
+    /// whether any flag in the set was given since the parser was last reset
+    bool touched_;
+} argparse_flag_set_t;
+
+/**
+ * @brief Struct representing a file mapped into memory by the parser
+ *
+ * The file is mapped privately, so tokens are decoded and NUL-terminated in
+ * copy-on-write pages without modifying the file on disk. When the parser
+ * caches tokens, the mapping may instead be of the file's token cache.
+ */
+typedef struct {
+    /// start of the mapping, NULL for an empty file
+    char *data_;
+    /// size of the mapping in bytes
+    size_t size_;
+    /// NUL-terminated tokens packed back-to-back within the mapping
+    char *tokens_;
+    /// number of tokens in `tokens_`
+    size_t num_tokens_;
+    /// offset of each token from `tokens_` (NULL if not loaded from a cache)
+    const uint64_t *offsets_;
+} argparse_mapping_t;
+
+/**
+ * @brief Struct representing a slot in the parser's index of environment
+ * variables declared by arguments
+ */
+typedef struct {
+    /// argument declaring the variable (NULL if the slot is empty)
+    argparse_arg_t *arg_;
+    /// value of the variable found in the last scan of the environment
+    const char *value_;
+} argparse_env_slot_t;
+
+/**
+ * @brief Struct representing an argument touched by a parse, together with
+ * the value it held before it was first touched
+ */
+typedef struct {
+    /// argument touched by the parse
+    argparse_arg_t *arg_;
+    /// bytes of the value to restore on reset, held by the member matching
+    /// the type of the argument
+    union {
+        int int_;
+        float float_;
+        bool bool_;
+        const char *string_;
+        void *array_;
+        int64_t int64_;
+        uint32_t uint32_;
+        uint64_t uint64_;
+    } default_;
+} argparse_touched_t;
+
+struct argument_parser_t;
+
+/**
+ * @brief Function adding the arguments of a subcommand to its parser
+ *
+ * @param parser Pointer to the parser of the subcommand
+ * @param context User context of the subcommand
+ * @return argparse_error_t Error struct, as returned by
+ * `argparse_add_argument`
+ */
+typedef argparse_error_t (*argparse_subcommand_init_t)(
+    struct argument_parser_t *parser, void *context);
+
+/**
+ * @brief Struct representing a subcommand
+ *
+ * The arguments of a subcommand are only added, by `init_`, to a parser
+ * created when the subcommand is selected on the command line.
+ */
+typedef struct argparse_subcommand_t {
+    /** User-provided information */
+    /// name selecting the subcommand
+    const char *name_;
+    /// function adding the arguments of the subcommand to its parser
+    argparse_subcommand_init_t init_;
+    /// user context passed to `init_`
+    void *context_;
+    /// help description for the subcommand
+    const char *help_;
+
+    /** Parser state */
+    /// pointer to the next subcommand, for linked list
+    struct argparse_subcommand_t *next_;
+} argparse_subcommand_t;
+
 /**
  * @brief Struct representing the parser
  *
@@ -161,7 +475,7 @@ typedef struct argparse_arg_t {
  * epilog, as well as linked lists to all the options and positional arguments
  * that have been added to the parser.
  */
-typedef struct {
+typedef struct argument_parser_t {
     /// number of arguments
     int argc_;
     /// array of argument strings
@@ -178,6 +492,78 @@ typedef struct {
     argparse_arg_t *options_;
     /// linked list of positional arguments added to parser
     argparse_arg_t *positional_args_;
+    /// linked list of feature flag sets added to parser
+    argparse_flag_set_t *flag_sets_;
+    /// linked list of subcommands added to parser
+    argparse_subcommand_t *subcommands_;
+
+    /// characters that prefix response file arguments (NULL if disabled)
+    const char *fromfile_prefix_chars_;
+    /// whether tokenised response files are cached in sidecar files
+    bool token_cache_;
+    /// file of values for arguments absent from the command line (NULL if none)
+    const char *config_file_;
+    /// struct holding the values of arguments bound to fields (NULL if none)
+    void *struct_;
+    /// size of `struct_` in bytes
+    size_t struct_size_;
+
+    /** Resources owned by the parser, released by `argparse_free` */
+    /// argument vector with response files expanded (NULL if not expanded)
+    char **expanded_argv_;
+    /// argument vector replaced by `expanded_argv_`, restored on reset
+    char **unexpanded_argv_;
+    /// number of arguments in `unexpanded_argv_`
+    int unexpanded_argc_;
+    /// response files mapped into memory
+    argparse_mapping_t *mappings_;
+    /// number of entries in `mappings_`
+    size_t num_mappings_;
+    /// open-addressing hash table of environment variables declared by
+    /// arguments, indexed by variable name
+    argparse_env_slot_t *env_index_;
+    /// number of slots in `env_index_`, zero or a power of two
+    size_t env_index_size_;
+    /// number of arguments in `env_index_`
+    size_t num_env_args_;
+    /// arguments touched since the parser was last reset, in order
+    argparse_touched_t *touched_log_;
+    /// number of entries in `touched_log_`
+    size_t num_touched_;
+    /// number of entries allocated for `touched_log_`
+    size_t touched_capacity_;
+    /// open-addressing hash table of subcommands, indexed by name
+    argparse_subcommand_t **subcommand_index_;
+    /// number of slots in `subcommand_index_`, zero or a power of two
+    size_t subcommand_index_size_;
+    /// number of subcommands in `subcommand_index_`
+    size_t num_subcommands_;
+    /// subcommand selected by the last parse (NULL if none)
+    argparse_subcommand_t *subcommand_;
+    /// parser of the arguments of `subcommand_` (NULL if none)
+    struct argument_parser_t *subparser_;
+    /// arguments added to the parser, indexed by bit
+    argparse_arg_t **bit_args_;
+    /// number of arguments in `bit_args_`
+    size_t num_bits_;
+    /// number of words allocated for each of the bitsets of arguments
+    size_t bit_words_;
+    /// bitset of the arguments given since the parser was last reset
+    uint64_t *present_;
+    /// bitset of the required arguments
+    uint64_t *required_bits_;
+    /// bitset of the arguments with the count action
+    uint64_t *count_bits_;
+    /// exclusive groups and dependencies between arguments, allocated from
+    /// the arena
+    struct argparse_rule *rules_;
+
+    /// whether single store values are converted on access rather than parsed
+    bool lazy_;
+    /// whether string values are copied into the arena when parsed
+    bool copy_strings_;
+    /// blocks of memory allocated from by the `argparse_arena_*` functions
+    struct argparse_arena_block *arena_;
 } argument_parser_t;
 
 /********************* FUNCTION DECLARATIONS *********************/
@@ -219,7 +605,12 @@ argparse_error_t argparse_init(argument_parser_t *parser, int argc, char **argv,
  * parsed can lead to undefined behaviour. This means that if the arguments are
  * created in a different function from the one where `argparse_parse_args` is
  * called, the user is responsible for ensuring that `arg` is correctly
- * dynamically allocated.
+ * dynamically allocated, for example with `argparse_arena_arg`.
+ *
+ * @note An argument is linked into the parser it is added to, so it can only
+ * be added to another parser once that parser is freed, and is otherwise
+ * rejected with `ARGPARSE_CONFLICTING_OPTIONS_ERROR`. Arguments shared by
+ * several parsers should be added with `argparse_add_parent`.
  */
 argparse_error_t argparse_add_argument(argument_parser_t *parser,
                                        argparse_arg_t *arg);
@@ -240,6 +631,100 @@ argparse_error_t argparse_add_argument(argument_parser_t *parser,
 argparse_error_t argparse_add_arguments(argument_parser_t *parser,
                                         argparse_arg_t *args, size_t num_args);
 
+/**
+ * @brief Adds a shared set of arguments, such as common logging options, to
+ * the parser
+ *
+ * @param parser Pointer to the parser
+ * @param args Array of arguments to add, which is only read
+ * @param num_args The number of arguments in args
+ * @return An `argparse_error_t` indicating success or failure
+ *
+ * @note The same `args` can be added to any number of parsers and
+ * subparsers, and can be const. Each parser links instances of the arguments
+ * allocated in one block from its arena, holding the parser state of the
+ * arguments, while the strings, choices and value pointers of `args` are
+ * shared rather than duplicated. The lifetime of `args` must extend as for
+ * `argparse_add_argument`.
+ */
+argparse_error_t argparse_add_parent(argument_parser_t *parser,
+                                     const argparse_arg_t *args,
+                                     size_t num_args);
+
+/**
+ * @brief Adds a group of mutually exclusive arguments to the parser
+ *
+ * @param parser Pointer to the parser
+ * @param names Names of the arguments in the group, each an option's flag
+ * such as `-t`, its long name with or without the leading `--`, or the name of
+ * a positional argument
+ * @param num_names The number of names in names
+ * @param required Whether one argument of the group must be given
+ * @return An `argparse_error_t` indicating success or failure
+ *
+ * @note The arguments must already be added to the parser. Giving more than
+ * one argument of the group results in `ARGPARSE_CONFLICTING_OPTIONS_ERROR`.
+ */
+argparse_error_t argparse_add_exclusive_group(argument_parser_t *parser,
+                                              const char *const *names,
+                                              size_t num_names, bool required);
+
+/**
+ * @brief Adds a dependency of the argument `name` on other arguments
+ *
+ * @param parser Pointer to the parser
+ * @param name Name of the dependent argument, as for
+ * `argparse_add_exclusive_group`
+ * @param names Names of the arguments which must be given with `name`
+ * @param num_names The number of names in names
+ * @return An `argparse_error_t` indicating success or failure
+ *
+ * @note The arguments must already be added to the parser. Giving `name`
+ * without each of `names` results in `ARGPARSE_MISSING_ARGUMENT_ERROR`.
+ */
+argparse_error_t argparse_add_requires(argument_parser_t *parser,
+                                       const char *name,
+                                       const char *const *names,
+                                       size_t num_names);
+
+/**
+ * @brief Adds a subcommand to the parser
+ *
+ * @param parser Pointer to the parser
+ * @param subcommand Pointer to the subcommand
+ * @return An `argparse_error_t` indicating success or failure
+ *
+ * @note The first token after the positional arguments of a parser with
+ * subcommands selects a subcommand, found by hashing its name, so a
+ * positional argument taking a variable number of values also takes the
+ * subcommand's name. The arguments after the subcommand are parsed by a new
+ * parser holding only the arguments the subcommand's `init_` adds, so the
+ * cost of a parse does not grow with the number of subcommands.
+ * The selected subcommand and its parser are `subcommand_` and `subparser_`,
+ * which last until the parser is reset or freed. The lifetime of
+ * `*subcommand` must extend as for `argparse_add_argument`.
+ */
+argparse_error_t argparse_add_subcommand(argument_parser_t *parser,
+                                         argparse_subcommand_t *subcommand);
+
+/**
+ * @brief Adds a set of boolean feature flags to the parser
+ *
+ * @param parser Pointer to the parser
+ * @param set Pointer to the flag set
+ * @return An `argparse_error_t` indicating success or failure
+ *
+ * @note The names are indexed in a hash table allocated from the parser's
+ * arena, so each flag is found in constant time however many flags the set
+ * holds. `bits_` is initialised from `defaults_` when the set is added. When
+ * the arguments are parsed, flags given on the command line are collected in
+ * whole-word masks that are applied to the defaults once parsing finishes,
+ * with the last of `--enable-X` and `--no-X` taking effect. The lifetime of
+ * `*set` must extend as for `argparse_add_argument`.
+ */
+argparse_error_t argparse_add_flag_set(argument_parser_t *parser,
+                                       argparse_flag_set_t *set);
+
 /**
  * @brief Parses the command-line arguments
  *
@@ -249,9 +734,240 @@ argparse_error_t argparse_add_arguments(argument_parser_t *parser,
  * @note The arguments should already be added to the parser. The parser and
  * all the arguments that have been added to the parser must also be in scope
  * when this function is called to avoid undefined behaviour.
+ *
+ * @note If `fromfile_prefix_chars_` is set, any argument starting with one of
+ * its characters names a response file, such as `@args.txt`, whose contents
+ * are split on whitespace and spliced into the argument vector in its place.
+ * Single quotes, double quotes and backslashes escape whitespace, and response
+ * files may name further response files. Call `argparse_free` once the parsed
+ * values are no longer needed.
+ *
+ * @note If `token_cache_` is set, the tokens of each response file are saved
+ * in a sidecar file named by appending `.argcache` to its path. Later parses
+ * map the sidecar instead of tokenising the file again, as long as the path,
+ * size, modification time and content hash of the file are unchanged. A
+ * sidecar is only trusted if it is a regular file owned by the effective user
+ * and writable by no one else, and it is written with mode 0600.
+ *
+ * @note If `config_file_` is set, each `name = value` line of the file supplies
+ * the value of the option with that long name, or the positional argument with
+ * that name, if it was not given on the command line. Blank lines, `#` and `;`
+ * comments and `[section]` headers are ignored, values may be quoted, and later
+ * lines override earlier ones, except for append, callback and dictionary
+ * arguments, which take every line in order. Flags take `true`, `yes`, `on` or
+ * `1`, or their opposites, and counts take a number. Errors in the file report
+ * its name and line.
+ *
+ * @note Arguments absent from the command line take their value from the
+ * environment variable named by `env_`, if it is set, in preference to the
+ * config file. The environment is scanned once per parse.
+ *
+ * If `lazy_` is set on the parser, the values of options and positional
+ * arguments storing a single value are only bound when parsed. They are
+ * converted and checked against the choices by the `argparse_get_*`
+ * accessors, which also report any conversion errors.
  */
 argparse_error_t argparse_parse_args(argument_parser_t *parser);
 
+/**
+ * @brief Parses the arguments like `argparse_parse_args`, collecting the
+ * tokens that match no argument instead of failing on them
+ *
+ * @param parser Pointer to the parser
+ * @param unknown Array receiving the indices into `argv_` of unknown tokens,
+ * in order
+ * @param capacity Number of indices `unknown` can hold
+ * @param num_unknown Pointer receiving the number of indices stored
+ * @return argparse_error_t Error struct containing information about the
+ * error, which is `ARGPARSE_CAPACITY_EXCEEDED_ERROR` if there are more than
+ * `capacity` unknown tokens
+ *
+ * @note The tokens following an unknown option which do not start with '-'
+ * are taken as its values, and collected with it, once no positional
+ * arguments remain to be filled. A group of short flags containing an unknown
+ * flag is collected whole, without applying any of its flags. No strings are
+ * copied, the tokens are `argv_[unknown[i]]`, which is the expanded argument
+ * vector if response files are enabled.
+ */
+argparse_error_t argparse_parse_known_args(argument_parser_t *parser,
+                                           int *unknown, size_t capacity,
+                                           size_t *num_unknown);
+
+/**
+ * @brief Gets the value of an integer argument
+ *
+ * @param parser Pointer to the parser
+ * @param name Long name of an option, with or without the leading `--`, its
+ * flag such as `-t`, or the name of a positional argument
+ * @param out Pointer receiving the value
+ * @return An `argparse_error_t` indicating success or failure, which is
+ * `ARGPARSE_TYPE_MISMATCH_ERROR` if the argument is not an integer or stores
+ * no value, as for a callback without a destination
+ *
+ * @note If the parser is in lazy mode, the value bound by the parse is
+ * converted and checked against the choices on first access, and the result
+ * is stored as usual so later accesses only read it. Unconverted values are
+ * converted the same way for `argparse_get_float` and `argparse_get_string`.
+ */
+argparse_error_t argparse_get_int(argument_parser_t *parser, const char *name,
+                                  int *out);
+
+/**
+ * @brief Gets the value of a float argument, as for `argparse_get_int`
+ */
+argparse_error_t argparse_get_float(argument_parser_t *parser,
+                                    const char *name, float *out);
+
+/**
+ * @brief Gets the value of a boolean argument, as for `argparse_get_int`
+ */
+argparse_error_t argparse_get_bool(argument_parser_t *parser, const char *name,
+                                   bool *out);
+
+/**
+ * @brief Gets the value of a string argument, as for `argparse_get_int`
+ */
+argparse_error_t argparse_get_string(argument_parser_t *parser,
+                                     const char *name, const char **out);
+
+/**
+ * @brief Gets the value of a 64-bit integer argument, as for
+ * `argparse_get_int`
+ */
+argparse_error_t argparse_get_int64(argument_parser_t *parser,
+                                    const char *name, int64_t *out);
+
+/**
+ * @brief Gets the value of an unsigned 32-bit integer argument, as for
+ * `argparse_get_int`
+ */
+argparse_error_t argparse_get_uint32(argument_parser_t *parser,
+                                     const char *name, uint32_t *out);
+
+/**
+ * @brief Gets the value of an unsigned 64-bit integer, size or duration
+ * argument, as for `argparse_get_int`
+ */
+argparse_error_t argparse_get_uint64(argument_parser_t *parser,
+                                     const char *name, uint64_t *out);
+
+/**
+ * @brief Looks up a key in a dictionary
+ *
+ * @param dict Pointer to the dictionary
+ * @param key NUL-terminated key to look up
+ * @return The value of the key, or NULL if the key was not given
+ */
+const char *argparse_dict_get(const argparse_dict_t *dict, const char *key);
+
+/**
+ * @brief Binds a struct whose fields hold the values of arguments
+ *
+ * @param parser Pointer to the parser
+ * @param config Pointer to the struct receiving parsed values
+ * @param defaults Pointer to a struct of default values copied into `config`
+ * (NULL to leave `config` unchanged)
+ * @param size Size of the struct in bytes
+ *
+ * @note Arguments created with `ARGPARSE_FIELD` or the `_FIELD` macros store
+ * their values at their offset within `config` instead of at `value_`. The
+ * struct must be bound before such arguments are added. Binding another
+ * struct of the same type redirects later parses, so results can be parsed
+ * into per-thread copies.
+ */
+void argparse_bind_struct(argument_parser_t *parser, void *config,
+                          const void *defaults, size_t size);
+
+/**
+ * @brief Restores the arguments touched by the previous parse
+ *
+ * @param parser Pointer to the parser
+ *
+ * @note Each argument whose count or value was changed since the parser was
+ * initialised or last reset has its count zeroed and its value restored to
+ * what it held before it was first changed. The parser records the arguments
+ * as they are touched, so the reset costs time in proportion to the arguments
+ * given rather than the arguments added. Response and config files mapped by
+ * the parse are unmapped, and an argument vector expanded from response files
+ * is replaced by the one it was expanded from. Set `argc_` and `argv_`, or
+ * call `argparse_parse_json_line` with the next line, to parse again.
+ */
+void argparse_reset(argument_parser_t *parser);
+
+/**
+ * @brief Allocates memory from the parser's arena
+ *
+ * @param parser Pointer to the parser
+ * @param size Number of bytes to allocate
+ * @return Pointer to uninitialised memory aligned for any type, or NULL if the
+ * memory cannot be allocated
+ *
+ * @note Allocations are bumped from large blocks and are only released, all at
+ * once, by `argparse_free`. This suits choices arrays and other data whose
+ * lifetime matches the parser.
+ */
+void *argparse_arena_alloc(argument_parser_t *parser, size_t size);
+
+/**
+ * @brief Creates a copy of an argument in the parser's arena
+ *
+ * @param parser Pointer to the parser
+ * @param arg Pointer to the argument to copy, such as a compound literal
+ * created by one of the argument macros
+ * @return Pointer to the copy, or NULL if the memory cannot be allocated
+ *
+ * @note The copy lives until `argparse_free` is called, so arguments can be
+ * created in helper functions and added to the parser without a separate heap
+ * allocation for each.
+ */
+argparse_arg_t *argparse_arena_arg(argument_parser_t *parser,
+                                   const argparse_arg_t *arg);
+
+/**
+ * @brief Copies a string into the parser's arena
+ *
+ * @param parser Pointer to the parser
+ * @param string NUL-terminated string to copy
+ * @return Pointer to the copy, or NULL if the memory cannot be allocated
+ *
+ * @note If `copy_strings_` is set on the parser, string values are copied
+ * with this function as they are parsed, so they remain valid if `argv` is
+ * later overwritten.
+ */
+const char *argparse_arena_strdup(argument_parser_t *parser,
+                                  const char *string);
+
+/**
+ * @brief Releases the resources owned by the parser
+ *
+ * @param parser Pointer to the parser
+ *
+ * @note String values parsed from response files and memory allocated from
+ * the parser's arena are owned by the parser, so they must not be used after
+ * this function is called. The parser must be initialised again before it is
+ * reused.
+ */
+void argparse_free(argument_parser_t *parser);
+
+/**
+ * @brief Parses one line of newline-delimited JSON as a set of arguments
+ *
+ * @param parser Pointer to the parser
+ * @param line Buffer holding a single flat JSON object
+ * @param len Length of `line` in bytes, excluding any NUL terminator
+ * @return An `argparse_error_t` indicating success or failure
+ *
+ * @note Each key is the long name of an option, with or without the leading
+ * `--`, or the name of a positional argument. Values may be strings, numbers,
+ * `true`, `false` or `null`, where `null` leaves the argument unset. The same
+ * conversion, choices and required checks as `argparse_parse_args` apply.
+ * Strings and numbers are decoded and NUL-terminated in place, so `line` is
+ * modified and must outlive any string values stored from it. Call
+ * `argparse_reset` between lines so that one line does not carry into the next.
+ */
+argparse_error_t argparse_parse_json_line(argument_parser_t *parser,
+                                          char *line, size_t len);
+
 /**
  * @brief Prints error message if there is an error
  *
@@ -284,6 +1000,9 @@ void argparse_check_error_and_exit(argparse_error_t error);
 #define REQUIRED true
 #define OPTIONAL false
 #define NO_CHOICES NULL
+#define ONE_OR_MORE (-1)
+#define ZERO_OR_MORE (-2)
+#define REMAINDER (-3)
 
 /********************* BASIC ARGUMENT MACROS *********************/
 
@@ -296,7 +1015,7 @@ void argparse_check_error_and_exit(argparse_error_t error);
  * with various properties, such as required options or choices lists.
  *
  * For the following macros:
- * - `type`: must be `INT`, `FLOAT`, `BOOL` or `STRING`
+ * - `type`: must be `INT`, `FLOAT`, `BOOL`, `STRING` or `DICT`
  * - `flag`: a character flag, used as short name of argument
  * - `name`: long-form name of argument, should generally have `--` prefix
  * - `res`: pointer to the variable where parsed result should be stored
@@ -312,7 +1031,8 @@ void argparse_check_error_and_exit(argparse_error_t error);
 
 /**
  * @brief Defines a basic argparse argument
- * @param type Argument type (must be INT, FLOAT, BOOL or STRING)
+ * @param type Argument type (must be INT, FLOAT, BOOL, STRING, DICT,
+ * ENUM, INT64, UINT32, UINT64, SIZE or DURATION)
  * @param ... Additional `argument_arg_t` fields
  *
  * @note All the fields of the argument, aside from type_, next_ and count_,
@@ -327,7 +1047,8 @@ void argparse_check_error_and_exit(argparse_error_t error);
 /**
  * @brief Initialises an already allocated argparse argument
  * @param ptr Pointer to memory allocated for an `argparse_arg_t` 
- * @param type Argument type (must be INT, FLOAT, BOOL or STRING)
+ * @param type Argument type (must be INT, FLOAT, BOOL, STRING, DICT,
+ * ENUM, INT64, UINT32, UINT64, SIZE or DURATION)
  * @param ... Additional `argparse_arg_t` fields
  *
  * @note The pointer `ptr` must not be NULL and should point to memory allocated
@@ -336,12 +1057,18 @@ void argparse_check_error_and_exit(argparse_error_t error);
  */
 #define ARGPARSE_ARG_INIT(ptr, type, ...)                                      \
     do {                                                                       \
-        *(ptr) = (argparse_arg_t){.type_ = ARGPARSE_##type##_TYPE,             \
-                                  .next_ = NULL,                               \
-                                  .count_ = 0,                                 \
-                                  __VA_ARGS__};                                \
+        argparse_arg_t argparse_tmp_ = ARGPARSE_ARG(type, __VA_ARGS__);        \
+        memcpy((ptr), &argparse_tmp_, sizeof(argparse_arg_t));                 \
     } while (0)
 
+/**
+ * @brief Designated initialisers binding an argument to `field` of the struct
+ * type `type` rather than to `value_`, for use in `ARGPARSE_ARG`
+ */
+#define ARGPARSE_FIELD(type, field)                                            \
+    .value_ = NULL, .offset_ = offsetof(type, field),                          \
+    .size_ = sizeof(((type *)0)->field)
+
 /********************* POSITIONAL ARGUMENT MACROS *********************/
 
 /**
@@ -359,6 +1086,37 @@ void argparse_check_error_and_exit(argparse_error_t error);
     ARGPARSE_ARG(type, '\0', (name), (res), ARGPARSE_STORE_ACTION, (help),     \
                  REQUIRED, (choices), (num_choices))
 
+/**
+ * @brief Creates a positional argument stored in `field` of the bound struct
+ * of type `config`
+ */
+#define ARGPARSE_POSITIONAL_FIELD(type, name, config, field, help)             \
+    ARGPARSE_ARG(type, '\0', (name), NULL, ARGPARSE_STORE_ACTION, (help),      \
+                 REQUIRED, NO_CHOICES, 0, NULL, offsetof(config, field),       \
+                 sizeof(((config *)0)->field))
+
+/**
+ * @brief Creates a positional argument taking `nargs` values, stored in the
+ * array `res` holding `capacity` values, or in an array allocated from the
+ * parser's arena whose address is stored at `res` if `capacity` is 0
+ */
+#define ARGPARSE_POSITIONAL_NARGS(type, name, res, help, nargs, capacity)      \
+    ARGPARSE_ARG(type, '\0', (name), (res), ARGPARSE_STORE_ACTION, (help),     \
+                 REQUIRED, NO_CHOICES, 0, NULL, 0, 0, (nargs), (capacity))
+
+/**
+ * @brief Creates a positional argument that takes the rest of the arguments,
+ * including those starting with '-'
+ *
+ * @note `res` points to a `char **` which is set to the tail of `argv_`
+ * without copying, with the number of arguments in `num_values_`. The
+ * argument can only be given on the command line, not in JSON, a config file
+ * or the environment.
+ */
+#define ARGPARSE_REMAINDER(name, res, help)                                    \
+    ARGPARSE_ARG(STRING, '\0', (name), (res), ARGPARSE_STORE_ACTION, (help),   \
+                 OPTIONAL, NO_CHOICES, 0, NULL, 0, 0, REMAINDER, 0)
+
 /********************* OPTION MACROS *********************/
 
 /**
@@ -383,8 +1141,79 @@ void argparse_check_error_and_exit(argparse_error_t error);
     ARGPARSE_ARG(type, (flag), (name), (res), ARGPARSE_STORE_ACTION, (help),   \
                  OPTIONAL, (choices), (num_choices))
 
+/**
+ * @brief Creates an option stored in `field` of the bound struct of type
+ * `config`
+ */
+#define ARGPARSE_OPTION_FIELD(type, flag, name, config, field, help)           \
+    ARGPARSE_ARG(type, (flag), (name), NULL, ARGPARSE_STORE_ACTION, (help),    \
+                 OPTIONAL, NO_CHOICES, 0, NULL, offsetof(config, field),       \
+                 sizeof(((config *)0)->field))
+
+/**
+ * @brief Creates an option taking `nargs` values, stored in the array `res`
+ * holding `capacity` values, or in an array allocated from the parser's arena
+ * whose address is stored at `res` if `capacity` is 0
+ */
+#define ARGPARSE_OPTION_NARGS(type, flag, name, res, help, nargs, capacity)    \
+    ARGPARSE_ARG(type, (flag), (name), (res), ARGPARSE_STORE_ACTION, (help),   \
+                 OPTIONAL, NO_CHOICES, 0, NULL, 0, 0, (nargs), (capacity))
+
+/**
+ * @brief Creates an option whose value is a list of numbers separated by
+ * `delimiter`, stored like the values of `ARGPARSE_OPTION_NARGS`
+ */
+#define ARGPARSE_OPTION_LIST(type, flag, name, res, help, delimiter, capacity) \
+    ARGPARSE_ARG(type, (flag), (name), (res), ARGPARSE_STORE_ACTION, (help),   \
+                 OPTIONAL, NO_CHOICES, 0, NULL, 0, 0, 0, (capacity),           \
+                 (delimiter))
+
 /********************* SPECIAL OPTION MACROS *********************/
 
+/**
+ * @brief Creates a dictionary option storing the `key=value` pair given in
+ * each occurrence in the `argparse_dict_t` at `res`
+ */
+#define ARGPARSE_DICT(flag, name, res, help)                                   \
+    ARGPARSE_ARG(DICT, (flag), (name), (res), ARGPARSE_STORE_ACTION, (help),   \
+                 OPTIONAL, NO_CHOICES, 0)
+
+/**
+ * @brief Creates an option that invokes `callback` with `context` and the value
+ * of each occurrence as it is parsed, storing the value at `res` if it is not
+ * NULL
+ */
+#define ARGPARSE_CALLBACK(type, flag, name, res, help, callback, context)      \
+    ARGPARSE_ARG(type, (flag), (name), (res), ARGPARSE_CALLBACK_ACTION,        \
+                 (help), OPTIONAL, NO_CHOICES, 0, NULL, 0, 0, 0, 0, '\0',      \
+                 (callback), (context))
+
+/**
+ * @brief Creates an option storing the index in `choices` of the string given
+ * as its value in the `int` at `res`
+ */
+#define ARGPARSE_OPTION_ENUM(flag, name, res, help, choices, num_choices)      \
+    ARGPARSE_ARG(ENUM, (flag), (name), (res), ARGPARSE_STORE_ACTION, (help),   \
+                 OPTIONAL, (choices), (num_choices))
+
+/**
+ * @brief Creates a numeric option whose value must lie between `min` and `max`
+ * inclusive
+ */
+#define ARGPARSE_OPTION_RANGE(type, flag, name, res, help, min, max)           \
+    ARGPARSE_ARG(type, (flag), (name), (res), ARGPARSE_STORE_ACTION, (help),   \
+                 OPTIONAL, NO_CHOICES, 0, NULL, 0, 0, 0, 0, '\0', NULL, NULL,  \
+                 ARGPARSE_MIN_INCLUSIVE | ARGPARSE_MAX_INCLUSIVE, (min),       \
+                 (max))
+
+/**
+ * @brief Creates an option that stores the value of each occurrence in the
+ * array `res` holding `capacity` values, with the number of values in `count_`
+ */
+#define ARGPARSE_APPEND(type, flag, name, res, help, capacity)                 \
+    ARGPARSE_ARG(type, (flag), (name), (res), ARGPARSE_APPEND_ACTION, (help),  \
+                 OPTIONAL, NO_CHOICES, 0, NULL, 0, 0, 0, (capacity))
+
 /**
  * @brief Creates an integer option that counts the occurrences of the argument
  * on the command line when parsing
@@ -418,6 +1247,42 @@ void argparse_check_error_and_exit(argparse_error_t error);
     ARGPARSE_ARG(BOOL, (flag), (name), (res), ARGPARSE_STORE_FALSE_ACTION,     \
                  (help), OPTIONAL, NO_CHOICES, 0)
 
+/**
+ * @brief Creates an option whose value falls back to the environment variable
+ * `env` when the option is not provided on the command line
+ */
+#define ARGPARSE_OPTION_ENV(type, flag, name, res, help, env)                  \
+    ARGPARSE_ARG(type, (flag), (name), (res), ARGPARSE_STORE_ACTION, (help),   \
+                 OPTIONAL, NO_CHOICES, 0, (env))
+
+/********************* FEATURE FLAG MACROS *********************/
+
+/**
+ * @brief Number of 64-bit words holding `num_flags` feature flags
+ */
+#define ARGPARSE_FLAG_WORDS(num_flags) (((num_flags) + 63) / 64)
+
+/**
+ * @brief Tests flag `index` in the words `bits` of a feature flag set
+ */
+#define ARGPARSE_FLAG_TEST(bits, index)                                        \
+    (((bits)[(index) / 64] >> ((index) % 64)) & 1)
+
+/**
+ * @brief Creates a set of `num_flags` feature flags named by `names`, enabled
+ * by `--enable-NAME` and disabled by `--no-NAME`
+ */
+#define ARGPARSE_FLAG_SET(names, num_flags, bits, defaults, help)              \
+    ((argparse_flag_set_t){.names_ = (names), (num_flags), (bits), (defaults), \
+                           NULL, NULL, (help)})
+
+/**
+ * @brief Creates a subcommand named `name` whose arguments are added by
+ * `init` with `context`
+ */
+#define ARGPARSE_SUBCOMMAND(name, init, context, help)                         \
+    ((argparse_subcommand_t){.name_ = (name), (init), (context), (help)})
+
 /** @} */ // end of ARGPARSE_MACROS group
 
 #ifdef __cplusplus
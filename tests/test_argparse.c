@@ -1,6 +1,10 @@
 #include "argparse.h"
 #include <criterion/criterion.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define TESTS_PRINT_HELP 0
 #define EPSILON_FLOAT 1e-5
@@ -2767,4 +2771,2544 @@ Test(argparse, add_arguments, .init = newlines) {
     cr_assert_eq(args[1].count_, 1);
     cr_assert_eq(args[2].count_, 0);
     cr_assert_eq(args[3].count_, 1);
-}
\ No newline at end of file
+}
+
+// JSON LINES
+Test(argparse, json_line_mixed, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog"};
+    cr_assert_eq(argparse_check_error(argparse_init(
+                     &parser, 1, argv, "Parsing a JSON line", NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int threads = -1, verbosity = -1;
+    float ratio = 0;
+    bool dry_run = false, cache = true;
+    const char *file = NULL, *mode = NULL;
+    const char *modes[] = {"fast", "slow"};
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(INT, 't', "--threads", &threads, "threads"),
+        ARGPARSE_OPTION(FLOAT, 'r', "--ratio", &ratio, "ratio"),
+        ARGPARSE_FLAG_TRUE('d', "--dry-run", &dry_run, "dry run"),
+        ARGPARSE_TOGGLE('c', "--cache", &cache, "cache"),
+        ARGPARSE_COUNT('v', "--verbose", &verbosity, "verbosity"),
+        ARGPARSE_OPTION_WITH_CHOICES(STRING, 'm', "--mode", &mode, "mode",
+                                     modes, 2),
+        ARGPARSE_POSITIONAL(STRING, "file", &file, "input file")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 7)),
+                 ARGPARSE_NO_ERROR);
+
+    char line[] = "{\"threads\": 8, \"--ratio\":0.5,\"dry-run\":true, "
+                  "\"cache\" : false, \"verbose\": 3, \"mode\": \"slow\", "
+                  "\"file\": \"some/long/directory/in\\\\put\\u00e9.txt\"}\n";
+    cr_assert_eq(argparse_check_error(
+                     argparse_parse_json_line(&parser, line, strlen(line))),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(threads, 8);
+    cr_assert(WITHIN(ratio, 0.5));
+    cr_assert_eq(dry_run, true);
+    cr_assert_eq(cache, false);
+    cr_assert_eq(verbosity, 3);
+    cr_assert_str_eq(mode, "slow");
+    cr_assert_str_eq(file, "some/long/directory/in\\put\xc3\xa9.txt");
+    cr_assert_eq(args[0].count_, 1);
+    cr_assert_eq(args[4].count_, 3);
+}
+
+Test(argparse, json_line_null_and_false, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog"};
+    cr_assert_eq(argparse_check_error(argparse_init(
+                     &parser, 1, argv, "Parsing a JSON line", NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int threads = 4;
+    bool dry_run = false;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(INT, 't', "--threads", &threads, "threads"),
+        ARGPARSE_FLAG_TRUE('d', "--dry-run", &dry_run, "dry run")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+
+    char line[] = "{\"threads\":null,\"dry-run\":false}";
+    cr_assert_eq(argparse_check_error(
+                     argparse_parse_json_line(&parser, line, strlen(line))),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(threads, 4);
+    cr_assert_eq(dry_run, false);
+    cr_assert_eq(args[0].count_, 0);
+    cr_assert_eq(args[1].count_, 0);
+}
+
+Test(errors, json_line_invalid, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog"};
+    cr_assert_eq(argparse_check_error(argparse_init(
+                     &parser, 1, argv, "Parsing a JSON line", NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int threads = 4;
+    const char *name = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(INT, 't', "--threads", &threads, "threads"),
+        ARGPARSE_OPTION_REQUIRED(STRING, 'n', "--name", &name, "name")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+
+    char line0[] = "{\"threads\": 2}";
+    cr_assert_eq(argparse_check_error(
+                     argparse_parse_json_line(&parser, line0, strlen(line0))),
+                 ARGPARSE_MISSING_ARGUMENT_ERROR);
+
+    char line1[] = "{\"thread\": 2, \"name\": \"x\"}";
+    cr_assert_eq(argparse_check_error(
+                     argparse_parse_json_line(&parser, line1, strlen(line1))),
+                 ARGPARSE_ARGUMENT_UNKNOWN_ERROR);
+
+    char line2[] = "{\"threads\": [2], \"name\": \"x\"}";
+    cr_assert_eq(argparse_check_error(
+                     argparse_parse_json_line(&parser, line2, strlen(line2))),
+                 ARGPARSE_INVALID_JSON_ERROR);
+
+    char line3[] = "{\"threads\": 2, \"name\": \"x}";
+    cr_assert_eq(argparse_check_error(
+                     argparse_parse_json_line(&parser, line3, strlen(line3))),
+                 ARGPARSE_INVALID_JSON_ERROR);
+
+    char line4[] = "{\"threads\": 2,}";
+    cr_assert_eq(argparse_check_error(
+                     argparse_parse_json_line(&parser, line4, strlen(line4))),
+                 ARGPARSE_INVALID_JSON_ERROR);
+
+    // only true, false, null and numbers may be unquoted
+    const char *literals[] = {"abc", "+2", "02", "2.", ".5", "1e", "True"};
+    for (size_t i = 0; i < sizeof(literals) / sizeof(literals[0]); i++) {
+        char line[64];
+        snprintf(line, sizeof(line), "{\"name\": %s}", literals[i]);
+        cr_assert_eq(argparse_check_error(
+                         argparse_parse_json_line(&parser, line, strlen(line))),
+                     ARGPARSE_INVALID_JSON_ERROR);
+    }
+    argparse_free(&parser);
+}
+
+// RESPONSE FILES
+static void write_file(const char *path, const char *contents) {
+    FILE *file = fopen(path, "w");
+    cr_assert_neq(file, NULL);
+    fputs(contents, file);
+    fclose(file);
+}
+
+Test(argparse, response_file, .init = newlines) {
+    argument_parser_t parser;
+
+    write_file("/tmp/argparse_test_args.txt",
+               "--value 52\n--name 'hello world'\n\"quoted \\\"name\\\"\"");
+    char *argv[] = {"./prog", "-v", "1", "@/tmp/argparse_test_args.txt"};
+    cr_assert_eq(argparse_check_error(argparse_init(
+                     &parser, 4, argv, "Response file", NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.fromfile_prefix_chars_ = "@";
+
+    int value = 9999;
+    const char *name = NULL, *positional = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(INT, 'v', "--value", &value, "a value"),
+        ARGPARSE_OPTION(STRING, 'n', "--name", &name, "a name"),
+        ARGPARSE_POSITIONAL(STRING, "pos", &positional, "a positional")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 3)),
+                 ARGPARSE_NO_ERROR);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(parser.argc_, 7);
+    cr_assert_eq(value, 52);
+    cr_assert_eq(args[0].count_, 2);
+    cr_assert_str_eq(name, "hello world");
+    cr_assert_str_eq(positional, "quoted \"name\"");
+    argparse_free(&parser);
+}
+
+Test(argparse, response_file_after_reset, .init = newlines) {
+    argument_parser_t parser;
+
+    write_file("/tmp/argparse_test_reuse_a.rsp", "--value 1");
+    write_file("/tmp/argparse_test_reuse_b.rsp", "--value 2 --name b");
+    char *argv[] = {"./prog", "@/tmp/argparse_test_reuse_a.rsp"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 2, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.fromfile_prefix_chars_ = "@";
+
+    int value = 0;
+    const char *name = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(INT, 'v', "--value", &value, "a value"),
+        ARGPARSE_OPTION(STRING, 'n', "--name", &name, "a name")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(value, 1);
+
+    // reset restores the unexpanded vector, and a new one is expanded
+    argparse_reset(&parser);
+    cr_assert_eq(parser.argc_, 1);
+    cr_assert_eq(parser.num_mappings_, 0);
+    char *argv2[] = {"@/tmp/argparse_test_reuse_b.rsp"};
+    parser.argc_ = 1;
+    parser.argv_ = argv2;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(value, 2);
+    cr_assert_str_eq(name, "b");
+    argparse_free(&parser);
+}
+
+Test(argparse, response_file_nested, .init = newlines) {
+    argument_parser_t parser;
+
+    write_file("/tmp/argparse_test_outer.txt",
+               "-x 1 @/tmp/argparse_test_inner.txt -z 3");
+    write_file("/tmp/argparse_test_inner.txt", "-y\t2 ''");
+    char *argv[] = {"./prog", "+/tmp/argparse_test_outer.txt"};
+    cr_assert_eq(argparse_check_error(argparse_init(
+                     &parser, 2, argv, "Nested response files", NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.fromfile_prefix_chars_ = "@+";
+
+    int x = 0, y = 0, z = 0;
+    const char *empty = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(INT, 'x', "--x", &x, "x"),
+        ARGPARSE_OPTION(INT, 'y', "--y", &y, "y"),
+        ARGPARSE_OPTION(INT, 'z', "--z", &z, "z"),
+        ARGPARSE_POSITIONAL(STRING, "empty", &empty, "an empty string")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 4)),
+                 ARGPARSE_NO_ERROR);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(parser.num_mappings_, 2);
+    cr_assert_eq(x, 1);
+    cr_assert_eq(y, 2);
+    cr_assert_eq(z, 3);
+    cr_assert_str_eq(empty, "");
+    argparse_free(&parser);
+}
+
+Test(errors, response_file_missing, .init = newlines) {
+    argument_parser_t parser;
+
+    write_file("/tmp/argparse_test_cycle_a.txt",
+               "-x 1 @/tmp/argparse_test_cycle_b.txt");
+    write_file("/tmp/argparse_test_cycle_b.txt",
+               "@/tmp/argparse_test_cycle_a.txt");
+    char *argv0[] = {"./prog", "@/tmp/argparse_test_cycle_a.txt"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 2, argv0,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.fromfile_prefix_chars_ = "@";
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_FILE_ERROR);
+    argparse_free(&parser);
+
+    char *argv1[] = {"./prog", "@/tmp/argparse_test_does_not_exist.txt"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 2, argv1,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.fromfile_prefix_chars_ = "@";
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_FILE_ERROR);
+    argparse_free(&parser);
+}
+
+Test(argparse, response_file_token_cache, .init = newlines) {
+    argument_parser_t parser;
+
+    const char *cache = "/tmp/argparse_test_cached.txt.argcache";
+    const char *moved = "/tmp/argparse_test_cached.txt.argcache.moved";
+    unlink(cache);
+    unlink(moved);
+    write_file("/tmp/argparse_test_cached.txt", "--name \"cached name\" 7");
+    char *argv[] = {"./prog", "@/tmp/argparse_test_cached.txt"};
+
+    for (int run = 0; run < 5; run++) {
+        if (run == 2) {
+            // a changed file invalidates the cache
+            write_file("/tmp/argparse_test_cached.txt", "--name other 8");
+        } else if (run == 3) {
+            // a cache others can write is not trusted
+            cr_assert_eq(chmod(cache, 0666), 0);
+        } else if (run == 4) {
+            // nor is a link to a valid cache
+            cr_assert_eq(rename(cache, moved), 0);
+            cr_assert_eq(symlink(moved, cache), 0);
+        }
+        cr_assert_eq(argparse_check_error(argparse_init(
+                         &parser, 2, argv, "Cached response file", NO_EPILOG)),
+                     ARGPARSE_NO_ERROR);
+        parser.fromfile_prefix_chars_ = "@";
+        parser.token_cache_ = true;
+
+        int value = 0;
+        const char *name = NULL;
+        argparse_arg_t args[] = {
+            ARGPARSE_OPTION(STRING, 'n', "--name", &name, "a name"),
+            ARGPARSE_POSITIONAL(INT, "value", &value, "a value")};
+        cr_assert_eq(
+            argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+            ARGPARSE_NO_ERROR);
+
+        cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                     ARGPARSE_NO_ERROR);
+        cr_assert_eq(access(cache, F_OK), 0);
+        // the first run tokenises the file, the second maps the cache
+        cr_assert_eq(parser.mappings_[0].offsets_ != NULL, run == 1);
+        cr_assert_str_eq(name, run < 2 ? "cached name" : "other");
+        cr_assert_eq(value, run < 2 ? 7 : 8);
+        argparse_free(&parser);
+    }
+
+    // the cache replaced the link rather than writing through it
+    struct stat st;
+    cr_assert_eq(lstat(cache, &st), 0);
+    cr_assert(S_ISREG(st.st_mode));
+    cr_assert_eq(st.st_mode & 0777, 0600);
+    unlink(moved);
+}
+
+// CONFIG FILES
+Test(argparse, config_file_merged_with_argv, .init = newlines) {
+    argument_parser_t parser;
+
+    write_file("/tmp/argparse_test_config.ini",
+               "# defaults\n"
+               "[job]\n"
+               "threads = 4\n"
+               "name = \"from config\"\n"
+               "--ratio=0.25\n"
+               "  ; overridden below\n"
+               "verbose = 1\n"
+               "verbose = 2\n"
+               "cache = off\n"
+               "dry-run = yes\n"
+               "file = input.txt");
+    char *argv[] = {"./prog", "--threads", "16"};
+    cr_assert_eq(argparse_check_error(argparse_init(
+                     &parser, 3, argv, "Config file", NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.config_file_ = "/tmp/argparse_test_config.ini";
+
+    int threads = 0, verbosity = 0;
+    float ratio = 0;
+    bool cache = true, dry_run = false;
+    const char *name = NULL, *file = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(INT, 't', "--threads", &threads, "threads"),
+        ARGPARSE_OPTION(STRING, 'n', "--name", &name, "name"),
+        ARGPARSE_OPTION(FLOAT, 'r', "--ratio", &ratio, "ratio"),
+        ARGPARSE_COUNT('v', "--verbose", &verbosity, "verbosity"),
+        ARGPARSE_TOGGLE('c', "--cache", &cache, "cache"),
+        ARGPARSE_FLAG_TRUE('d', "--dry-run", &dry_run, "dry run"),
+        ARGPARSE_POSITIONAL(STRING, "file", &file, "input file")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 7)),
+                 ARGPARSE_NO_ERROR);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(threads, 16);
+    cr_assert_eq(args[0].count_, 1);
+    cr_assert_str_eq(name, "from config");
+    cr_assert(WITHIN(ratio, 0.25));
+    cr_assert_eq(verbosity, 2);
+    cr_assert_eq(cache, false);
+    cr_assert_eq(dry_run, true);
+    cr_assert_str_eq(file, "input.txt");
+    argparse_free(&parser);
+}
+
+Test(argparse, config_file_later_false_flag_and_zero_count,
+     .init = newlines) {
+    argument_parser_t parser;
+
+    write_file("/tmp/argparse_test_config_false.ini",
+               "dry-run = true\n"
+               "dry-run = false\n"
+               "verbose = 3\n"
+               "verbose = 0\n");
+    char *argv[] = {"./prog"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 1, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.config_file_ = "/tmp/argparse_test_config_false.ini";
+
+    int verbosity = 0;
+    bool dry_run = false;
+    argparse_arg_t args[] = {
+        ARGPARSE_COUNT('v', "--verbose", &verbosity, "verbosity"),
+        ARGPARSE_FLAG_TRUE('d', "--dry-run", &dry_run, "dry run")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(dry_run, false);
+    cr_assert_eq(verbosity, 0);
+    argparse_free(&parser);
+}
+
+Test(argparse, config_file_repeated_append_and_dict, .init = newlines) {
+    argument_parser_t parser;
+
+    write_file("/tmp/argparse_test_config_append.ini",
+               "define = a=1\n"
+               "include = x\n"
+               "define = b=2\n"
+               "include = y\n"
+               "exclude = z\n");
+    char *argv[] = {"./prog", "--exclude", "w"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 3, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.config_file_ = "/tmp/argparse_test_config_append.ini";
+
+    const char *includes[4] = {NULL}, *excludes[4] = {NULL};
+    argparse_dict_t defines = {.policy_ = ARGPARSE_DICT_LAST_WINS};
+    argparse_arg_t args[] = {
+        ARGPARSE_APPEND(STRING, 'I', "--include", includes, "include", 4),
+        ARGPARSE_APPEND(STRING, 'X', "--exclude", excludes, "exclude", 4),
+        ARGPARSE_DICT('D', "--define", &defines, "defines")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 3)),
+                 ARGPARSE_NO_ERROR);
+
+    // every line of an accumulating argument is kept, in file order, unless
+    // the argument was given on the command line
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(args[0].count_, 2);
+    cr_assert_str_eq(includes[0], "x");
+    cr_assert_str_eq(includes[1], "y");
+    cr_assert_eq(args[1].count_, 1);
+    cr_assert_str_eq(excludes[0], "w");
+    cr_assert_eq(defines.num_entries_, 2);
+    cr_assert_str_eq(defines.entries_[0].value_, "1");
+    cr_assert_str_eq(defines.entries_[1].value_, "2");
+    argparse_free(&parser);
+}
+
+Test(errors, config_file_invalid, .init = newlines) {
+    argument_parser_t parser;
+
+    write_file("/tmp/argparse_test_bad_config.ini",
+               "threads = 4\n"
+               "mode = medium\n");
+    char *argv[] = {"./prog"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 1, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.config_file_ = "/tmp/argparse_test_bad_config.ini";
+
+    int threads = 0;
+    const char *mode = NULL;
+    const char *modes[] = {"fast", "slow"};
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(INT, 't', "--threads", &threads, "threads"),
+        ARGPARSE_OPTION_WITH_CHOICES(STRING, 'm', "--mode", &mode, "mode",
+                                     modes, 2)};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+
+    argparse_error_t error = argparse_parse_args(&parser);
+    cr_assert_eq(argparse_check_error(error), ARGPARSE_INVALID_CHOICE_ERROR);
+    cr_assert_str_eq(error.file_name, "/tmp/argparse_test_bad_config.ini");
+    cr_assert_eq(error.line_num, 2);
+    argparse_free(&parser);
+
+    write_file("/tmp/argparse_test_bad_config.ini", "\nthreads 4\n");
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 1, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.config_file_ = "/tmp/argparse_test_bad_config.ini";
+    args[0].next_ = NULL;
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+    error = argparse_parse_args(&parser);
+    cr_assert_eq(argparse_check_error(error), ARGPARSE_INVALID_CONFIG_ERROR);
+    cr_assert_eq(error.line_num, 2);
+    argparse_free(&parser);
+}
+
+// ENVIRONMENT VARIABLES
+Test(argparse, env_fallback, .init = newlines) {
+    argument_parser_t parser;
+
+    setenv("ARGPARSE_TEST_THREADS", "12", 1);
+    setenv("ARGPARSE_TEST_NAME", "from env", 1);
+    setenv("ARGPARSE_TEST_CACHE", "no", 1);
+    unsetenv("ARGPARSE_TEST_UNSET");
+    char *argv[] = {"./prog", "--name", "from argv"};
+    cr_assert_eq(argparse_check_error(argparse_init(
+                     &parser, 3, argv, "Environment variables", NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int threads = 0, ratio = 5;
+    bool cache = true;
+    const char *name = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION_ENV(INT, 't', "--threads", &threads, "threads",
+                            "ARGPARSE_TEST_THREADS"),
+        ARGPARSE_OPTION_ENV(STRING, 'n', "--name", &name, "name",
+                            "ARGPARSE_TEST_NAME"),
+        ARGPARSE_OPTION_ENV(INT, 'r', "--ratio", &ratio, "ratio",
+                            "ARGPARSE_TEST_UNSET"),
+        ARGPARSE_TOGGLE('c', "--cache", &cache, "cache")};
+    args[3].env_ = "ARGPARSE_TEST_CACHE";
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 4)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(parser.num_env_args_, 4);
+
+    if (TESTS_PRINT_HELP)
+        argparse_print_help(&parser);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(threads, 12);
+    cr_assert_eq(args[0].count_, 1);
+    cr_assert_str_eq(name, "from argv");
+    cr_assert_eq(ratio, 5);
+    cr_assert_eq(args[2].count_, 0);
+    cr_assert_eq(cache, false);
+    argparse_free(&parser);
+}
+
+Test(argparse, env_over_config, .init = newlines) {
+    argument_parser_t parser;
+
+    write_file("/tmp/argparse_test_env_config.ini", "threads = 3\nratio = 4");
+    setenv("ARGPARSE_TEST_THREADS", "7", 1);
+    char *argv[] = {"./prog"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 1, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.config_file_ = "/tmp/argparse_test_env_config.ini";
+
+    int threads = 0, ratio = 0, other = 0;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION_ENV(INT, 't', "--threads", &threads, "threads",
+                            "ARGPARSE_TEST_THREADS"),
+        ARGPARSE_OPTION(INT, 'r', "--ratio", &ratio, "ratio"),
+        ARGPARSE_OPTION_ENV(INT, 'o', "--other", &other, "other",
+                            "ARGPARSE_TEST_THREADS")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &args[2])),
+                 ARGPARSE_CONFLICTING_OPTIONS_ERROR);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(threads, 7);
+    cr_assert_eq(ratio, 4);
+    argparse_free(&parser);
+}
+
+// ARENA
+static argparse_error_t add_arena_args(argument_parser_t *parser, int *threads,
+                                       const char **name) {
+    const char **choices = argparse_arena_alloc(parser, 2 * sizeof(char *));
+    choices[0] = argparse_arena_strdup(parser, "alpha");
+    choices[1] = argparse_arena_strdup(parser, "beta");
+    argparse_arg_t *args[] = {
+        argparse_arena_arg(parser, &ARGPARSE_OPTION(INT, 't', "--threads",
+                                                    threads, "threads")),
+        argparse_arena_arg(parser, &ARGPARSE_OPTION(STRING, 'n', "--name",
+                                                    name, "name"))};
+    args[1]->choices_ = choices;
+    args[1]->num_choices_ = 2;
+    argparse_error_t error = argparse_add_argument(parser, args[0]);
+    if (error.error_val != ARGPARSE_NO_ERROR)
+        return error;
+    return argparse_add_argument(parser, args[1]);
+}
+
+Test(argparse, arena_helper_created_arguments, .init = newlines) {
+    argument_parser_t parser;
+
+    char name_arg[] = "beta";
+    char *argv[] = {"./prog", "-t", "4", "--name", name_arg};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 5, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.copy_strings_ = true;
+
+    int threads = 0;
+    const char *name = NULL;
+    cr_assert_eq(argparse_check_error(add_arena_args(&parser, &threads, &name)),
+                 ARGPARSE_NO_ERROR);
+
+    // large allocations get a block of their own
+    char *big = argparse_arena_alloc(&parser, 100000);
+    cr_assert_not_null(big);
+    memset(big, 0, 100000);
+    cr_assert_eq((uintptr_t)argparse_arena_alloc(&parser, 3) %
+                     _Alignof(max_align_t),
+                 0);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(threads, 4);
+    cr_assert_str_eq(name, "beta");
+    cr_assert_neq(name, name_arg);
+    name_arg[0] = 'x';
+    cr_assert_str_eq(name, "beta");
+    argparse_free(&parser);
+    cr_assert_null(parser.arena_);
+}
+
+Test(argparse, arena_arg_init, .init = newlines) {
+    int value = 0;
+    argparse_arg_t arg;
+    ARGPARSE_ARG_INIT(&arg, INT, .name_ = "--value", .value_ = &value);
+    cr_assert_eq(arg.type_, ARGPARSE_INT_TYPE);
+    cr_assert_str_eq(arg.name_, "--value");
+    cr_assert_eq(arg.value_, &value);
+    cr_assert_null(arg.next_);
+}
+
+// RESET
+Test(argparse, reset_reuse_parser, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-vv", "--threads", "8", "routes.txt"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 5, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int verbosity = 0, threads = 4;
+    float ratio = 0.5f;
+    bool cache = true;
+    const char *file = "default.txt";
+    argparse_arg_t args[] = {
+        ARGPARSE_COUNT('v', "--verbose", &verbosity, "verbosity"),
+        ARGPARSE_OPTION(INT, 't', "--threads", &threads, "threads"),
+        ARGPARSE_OPTION(FLOAT, 'r', "--ratio", &ratio, "ratio"),
+        ARGPARSE_FLAG_FALSE('c', "--no-cache", &cache, "cache"),
+        ARGPARSE_POSITIONAL(STRING, "file", &file, "file")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 5)),
+                 ARGPARSE_NO_ERROR);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(verbosity, 2);
+    cr_assert_eq(threads, 8);
+    cr_assert_str_eq(file, "routes.txt");
+    // only the count, threads and file arguments are touched
+    cr_assert_eq(parser.num_touched_, 3);
+
+    argparse_reset(&parser);
+    cr_assert_eq(parser.num_touched_, 0);
+    cr_assert_eq(verbosity, 0);
+    cr_assert_eq(threads, 4);
+    cr_assert_str_eq(file, "default.txt");
+    cr_assert_eq(args[0].count_, 0);
+    cr_assert_eq(args[1].count_, 0);
+    cr_assert_eq(args[4].count_, 0);
+
+    char *next_argv[] = {"-c", "--ratio", "2.5", "other.txt"};
+    parser.argc_ = 4;
+    parser.argv_ = next_argv;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(verbosity, 0);
+    cr_assert_eq(threads, 4);
+    cr_assert_float_eq(ratio, 2.5f, 1e-6);
+    cr_assert_eq(cache, false);
+    cr_assert_eq(args[1].count_, 0);
+    cr_assert_eq(args[3].count_, 1);
+
+    argparse_reset(&parser);
+    cr_assert_float_eq(ratio, 0.5f, 1e-6);
+    cr_assert_eq(cache, true);
+    argparse_free(&parser);
+}
+
+Test(argparse, reset_json_lines, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 1, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int threads = 4;
+    const char *name = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(INT, 't', "--threads", &threads, "threads"),
+        ARGPARSE_OPTION_REQUIRED(STRING, 'n', "--name", &name, "name")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+
+    char line0[] = "{\"threads\": 2, \"name\": \"x\"}";
+    cr_assert_eq(argparse_check_error(
+                     argparse_parse_json_line(&parser, line0, strlen(line0))),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(threads, 2);
+
+    // without a reset, the name from the previous line would satisfy required
+    argparse_reset(&parser);
+    char line1[] = "{\"threads\": 3}";
+    cr_assert_eq(argparse_check_error(
+                     argparse_parse_json_line(&parser, line1, strlen(line1))),
+                 ARGPARSE_MISSING_ARGUMENT_ERROR);
+
+    argparse_reset(&parser);
+    cr_assert_eq(threads, 4);
+    cr_assert_null(name);
+    argparse_free(&parser);
+}
+
+Test(argparse, reset_logs_only_counts_given, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-v"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 2, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int verbosity = 0, quietness = 0, level = 3;
+    argparse_arg_t args[] = {
+        ARGPARSE_COUNT('v', "--verbose", &verbosity, "verbosity"),
+        ARGPARSE_COUNT('q', "--quiet", &quietness, "quietness"),
+        ARGPARSE_COUNT('l', "--level", &level, "level")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 3)),
+                 ARGPARSE_NO_ERROR);
+
+    // a count left at 0 is not touched, unless it changes the value
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(verbosity, 1);
+    cr_assert_eq(quietness, 0);
+    cr_assert_eq(level, 0);
+    cr_assert_eq(parser.num_touched_, 2);
+
+    argparse_reset(&parser);
+    cr_assert_eq(verbosity, 0);
+    cr_assert_eq(level, 3);
+    argparse_free(&parser);
+}
+
+Test(argparse, reset_restores_unset_storage, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-v"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 2, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    // storage the caller never initialised need not hold a valid bool
+    union {
+        bool flag;
+        unsigned char byte;
+    } storage = {.byte = 47};
+    argparse_arg_t arg =
+        ARGPARSE_FLAG_TRUE('v', "--verbose", &storage.flag, "verbose");
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &arg)),
+                 ARGPARSE_NO_ERROR);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(storage.byte, 1);
+    argparse_reset(&parser);
+    cr_assert_eq(storage.byte, 47);
+    argparse_free(&parser);
+}
+
+// STRUCT BINDING
+typedef struct {
+    int threads;
+    float ratio;
+    bool cache;
+    const char *file;
+    int verbosity;
+} test_config_t;
+
+Test(argparse, struct_binding, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-vvv", "--ratio", "0.25", "--no-cache",
+                    "routes.txt"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 6, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    static const test_config_t defaults = {.threads = 4, .ratio = 1.0f,
+                                           .cache = true, .file = "none"};
+    test_config_t config;
+    argparse_bind_struct(&parser, &config, &defaults, sizeof(config));
+    cr_assert_eq(config.threads, 4);
+
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION_FIELD(INT, 't', "--threads", test_config_t, threads,
+                              "threads"),
+        ARGPARSE_OPTION_FIELD(FLOAT, 'r', "--ratio", test_config_t, ratio,
+                              "ratio"),
+        ARGPARSE_ARG(BOOL, .flag_ = 'c', .name_ = "--cache",
+                     .action_ = ARGPARSE_BOOLEAN_OPTIONAL_ACTION,
+                     .help_ = "cache", ARGPARSE_FIELD(test_config_t, cache)),
+        ARGPARSE_ARG(INT, .flag_ = 'v', .name_ = "--verbose",
+                     .action_ = ARGPARSE_COUNT_ACTION, .help_ = "verbosity",
+                     ARGPARSE_FIELD(test_config_t, verbosity)),
+        ARGPARSE_POSITIONAL_FIELD(STRING, "file", test_config_t, file,
+                                  "file")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 5)),
+                 ARGPARSE_NO_ERROR);
+
+    if (TESTS_PRINT_HELP)
+        argparse_print_help(&parser);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(config.threads, 4);
+    cr_assert_float_eq(config.ratio, 0.25f, 1e-6);
+    cr_assert_eq(config.cache, false);
+    cr_assert_str_eq(config.file, "routes.txt");
+    cr_assert_eq(config.verbosity, 3);
+
+    // a reset restores the defaults in the bound struct
+    argparse_reset(&parser);
+    cr_assert_eq(memcmp(&config, &defaults, sizeof(config)), 0);
+
+    // parse again into a second struct
+    test_config_t other;
+    argparse_bind_struct(&parser, &other, &defaults, sizeof(other));
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(other.verbosity, 3);
+    cr_assert_eq(config.verbosity, 0);
+    argparse_free(&parser);
+}
+
+Test(errors, struct_binding_invalid_fields, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 1, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    argparse_arg_t threads = ARGPARSE_OPTION_FIELD(
+        INT, 't', "--threads", test_config_t, threads, "threads");
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &threads)),
+                 ARGPARSE_INVALID_FIELD_ERROR);
+
+    test_config_t config;
+    argparse_bind_struct(&parser, &config, NULL, sizeof(config));
+    argparse_arg_t file = ARGPARSE_OPTION_FIELD(FLOAT, 'f', "--file",
+                                                test_config_t, file, "file");
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &file)),
+                 ARGPARSE_INVALID_FIELD_ERROR);
+
+    argparse_bind_struct(&parser, &config, NULL, sizeof(int));
+    argparse_arg_t ratio = ARGPARSE_OPTION_FIELD(FLOAT, 'r', "--ratio",
+                                                 test_config_t, ratio, "ratio");
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &ratio)),
+                 ARGPARSE_INVALID_FIELD_ERROR);
+    // a field wider than the whole struct
+    argparse_arg_t name = ARGPARSE_OPTION_FIELD(STRING, 'n', "--name",
+                                                test_config_t, file, "name");
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &name)),
+                 ARGPARSE_INVALID_FIELD_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &threads)),
+                 ARGPARSE_NO_ERROR);
+}
+
+// FEATURE FLAGS
+Test(argparse, feature_flags_enable_and_disable, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog",         "--enable-f3",   "--no-f130",
+                    "--enable-f64",   "--no-f64",      "--threads",
+                    "2",              "--enable-f129", "--disable-g1",
+                    "--turn-on-g0"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 10, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    // a set large enough to span several words
+    static char storage[200][8];
+    const char *names[200];
+    for (size_t i = 0; i < 200; i++) {
+        snprintf(storage[i], sizeof(storage[i]), "f%zu", i);
+        names[i] = storage[i];
+    }
+    uint64_t bits[ARGPARSE_FLAG_WORDS(200)];
+    uint64_t defaults[ARGPARSE_FLAG_WORDS(200)] = {0};
+    defaults[130 / 64] |= UINT64_C(1) << (130 % 64);
+    defaults[199 / 64] |= UINT64_C(1) << (199 % 64);
+    argparse_flag_set_t flags =
+        ARGPARSE_FLAG_SET(names, 200, bits, defaults, "features");
+    cr_assert_eq(argparse_check_error(argparse_add_flag_set(&parser, &flags)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert(ARGPARSE_FLAG_TEST(bits, 130));
+
+    const char *other_names[] = {"g0", "g1"};
+    uint64_t other_bits[1];
+    uint64_t other_defaults[1] = {0x2};
+    argparse_flag_set_t other =
+        ARGPARSE_FLAG_SET(other_names, 2, other_bits, other_defaults, "other");
+    other.enable_prefix_ = "--turn-on-";
+    other.disable_prefix_ = "--disable-";
+    cr_assert_eq(argparse_check_error(argparse_add_flag_set(&parser, &other)),
+                 ARGPARSE_NO_ERROR);
+
+    int threads = 0;
+    argparse_arg_t arg =
+        ARGPARSE_OPTION(INT, 't', "--threads", &threads, "threads");
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &arg)),
+                 ARGPARSE_NO_ERROR);
+
+    if (TESTS_PRINT_HELP)
+        argparse_print_help(&parser);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(threads, 2);
+    cr_assert(ARGPARSE_FLAG_TEST(bits, 3));
+    cr_assert_eq(ARGPARSE_FLAG_TEST(bits, 130), 0);
+    cr_assert_eq(ARGPARSE_FLAG_TEST(bits, 64), 0);
+    cr_assert(ARGPARSE_FLAG_TEST(bits, 129));
+    cr_assert(ARGPARSE_FLAG_TEST(bits, 199));
+    cr_assert_eq(ARGPARSE_FLAG_TEST(bits, 0), 0);
+    cr_assert_eq(other_bits[0], 0x1);
+
+    argparse_reset(&parser);
+    cr_assert_eq(memcmp(bits, defaults, sizeof(bits)), 0);
+    cr_assert_eq(other_bits[0], 0x2);
+    argparse_free(&parser);
+}
+
+Test(errors, feature_flags_unknown_and_duplicate, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "--enable-missing"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 2, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    const char *names[] = {"a", "b", "a"};
+    uint64_t bits[1];
+    argparse_flag_set_t duplicate =
+        ARGPARSE_FLAG_SET(names, 3, bits, NULL, "duplicate");
+    cr_assert_eq(
+        argparse_check_error(argparse_add_flag_set(&parser, &duplicate)),
+        ARGPARSE_CONFLICTING_OPTIONS_ERROR);
+
+    argparse_flag_set_t empty = ARGPARSE_FLAG_SET(names, 0, bits, NULL, "none");
+    cr_assert_eq(argparse_check_error(argparse_add_flag_set(&parser, &empty)),
+                 ARGPARSE_INVALID_FLAG_OR_NAME_ERROR);
+
+    argparse_flag_set_t flags = ARGPARSE_FLAG_SET(names, 2, bits, NULL, "ab");
+    cr_assert_eq(argparse_check_error(argparse_add_flag_set(&parser, &flags)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(bits[0], 0);
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_ARGUMENT_UNKNOWN_ERROR);
+    argparse_free(&parser);
+}
+
+// NARGS
+Test(argparse, nargs_buffers_and_arena, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "--weights", "0.5",   "-1.5",  "2",  "-p",
+                    "3",      "4",         "a.txt", "b.txt", "-q", "--tags"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 12, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    float weights[4] = {0};
+    int point[2] = {0};
+    const char **files = NULL;
+    const char **tags = NULL;
+    bool quiet = false;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION_NARGS(FLOAT, 'w', "--weights", weights, "weights",
+                              ONE_OR_MORE, 4),
+        ARGPARSE_OPTION_NARGS(INT, 'p', "--point", point, "point", 2, 2),
+        ARGPARSE_OPTION_NARGS(STRING, 't', "--tags", &tags, "tags",
+                              ZERO_OR_MORE, 0),
+        ARGPARSE_FLAG_TRUE('q', "--quiet", &quiet, "quiet"),
+        ARGPARSE_POSITIONAL_NARGS(STRING, "files", &files, "files",
+                                  ONE_OR_MORE, 0)};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 5)),
+                 ARGPARSE_NO_ERROR);
+
+    if (TESTS_PRINT_HELP)
+        argparse_print_help(&parser);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(args[0].num_values_, 3);
+    cr_assert_float_eq(weights[0], 0.5f, 1e-6);
+    cr_assert_float_eq(weights[1], -1.5f, 1e-6);
+    cr_assert_float_eq(weights[2], 2.0f, 1e-6);
+    cr_assert_eq(args[1].num_values_, 2);
+    cr_assert_eq(point[0], 3);
+    cr_assert_eq(point[1], 4);
+    cr_assert_eq(args[4].num_values_, 2);
+    cr_assert_str_eq(files[0], "a.txt");
+    cr_assert_str_eq(files[1], "b.txt");
+    cr_assert_eq(quiet, true);
+    cr_assert_eq(args[2].count_, 1);
+    cr_assert_eq(args[2].num_values_, 0);
+    cr_assert_not_null(tags);
+
+    argparse_reset(&parser);
+    cr_assert_null(files);
+    cr_assert_null(tags);
+    cr_assert_eq(args[0].num_values_, 0);
+    argparse_free(&parser);
+}
+
+Test(argparse, nargs_arena_array_reused, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "--ids", "1", "2", "3", "4", "5", "6", "7", "8"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 10, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int *ids = NULL;
+    argparse_arg_t arg = ARGPARSE_OPTION_NARGS(INT, 'i', "--ids", &ids, "ids",
+                                               ONE_OR_MORE, 0);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &arg)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    int *first = ids;
+    void *arena = parser.arena_;
+
+    // reparsing into the same array leaves the arena as it was
+    for (int i = 0; i < 10000; i++) {
+        argparse_reset(&parser);
+        parser.argc_ = 9;
+        parser.argv_ = argv + 1;
+        cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                     ARGPARSE_NO_ERROR);
+        cr_assert_eq(ids, first);
+    }
+    cr_assert_eq(ids[7], 8);
+    cr_assert_eq(parser.arena_, arena);
+
+    // a longer occurrence grows the array
+    argparse_reset(&parser);
+    char *argv2[] = {"--ids", "1", "2", "3", "4", "5", "6", "7", "8", "9"};
+    parser.argc_ = 10;
+    parser.argv_ = argv2;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(arg.num_values_, 9);
+    cr_assert_eq(ids[8], 9);
+    argparse_free(&parser);
+}
+
+Test(errors, nargs_missing_and_exceeded, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-p", "1", "-w", "1", "2", "3"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 7, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int point[2] = {0};
+    float weights[2];
+    bool flag;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION_NARGS(INT, 'p', "--point", point, "point", 2, 2),
+        ARGPARSE_OPTION_NARGS(FLOAT, 'w', "--weights", weights, "weights",
+                              ONE_OR_MORE, 2),
+        ARGPARSE_FLAG_TRUE('f', "--flag", &flag, "flag")};
+    args[2].nargs_ = 2;
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &args[2])),
+                 ARGPARSE_UNSUPPORTED_ACTION_ERROR);
+    argparse_arg_t small = ARGPARSE_OPTION_NARGS(INT, 'x', "--xyz", point,
+                                                 "too small", 3, 2);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &small)),
+                 ARGPARSE_UNSUPPORTED_ACTION_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+
+    // -w is not a value of the integer argument -p
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_ARGUMENT_MISSING_VALUE_ERROR);
+
+    argparse_reset(&parser);
+    parser.argc_ = 4;
+    parser.argv_ = argv + 3;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_CAPACITY_EXCEEDED_ERROR);
+    argparse_free(&parser);
+}
+
+// NUMERIC LISTS
+Test(argparse, list_ints_and_floats, .init = newlines) {
+    argument_parser_t parser;
+
+    // long list crossing the eight-digit fast path
+    static char ids[20000];
+    size_t len = 0;
+    for (int k = 0; k < 1000; k++) {
+        len += (size_t)snprintf(ids + len, sizeof(ids) - len, "%s%d",
+                                k ? "," : "", k * 2147483 + k % 7);
+    }
+    char small_list[] = "-2147483648,0x1F,+7,000000000000042,2147483647";
+    char *argv[] = {"./prog",  "--ids",   ids,       "-r",
+                    "0.5:-1.25:3", "--small", small_list};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 7, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int *parsed_ids = NULL;
+    float ratios[3];
+    int small[5];
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION_LIST(INT, 'i', "--ids", &parsed_ids, "ids", ',', 0),
+        ARGPARSE_OPTION_LIST(FLOAT, 'r', "--ratios", ratios, "ratios", ':', 3),
+        ARGPARSE_OPTION_LIST(INT, 's', "--small", small, "small", ',', 5)};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 3)),
+                 ARGPARSE_NO_ERROR);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(args[0].num_values_, 1000);
+    for (int k = 0; k < 1000; k++) {
+        cr_assert_eq(parsed_ids[k], k * 2147483 + k % 7);
+    }
+    cr_assert_eq(args[1].num_values_, 3);
+    cr_assert_float_eq(ratios[0], 0.5f, 1e-6);
+    cr_assert_float_eq(ratios[1], -1.25f, 1e-6);
+    cr_assert_float_eq(ratios[2], 3.0f, 1e-6);
+    cr_assert_eq(args[2].num_values_, 5);
+    cr_assert_eq(small[0], INT32_MIN);
+    cr_assert_eq(small[1], 31);
+    cr_assert_eq(small[2], 7);
+    // a leading zero is octal, as for a single int value
+    cr_assert_eq(small[3], 042);
+    cr_assert_eq(small[4], INT32_MAX);
+    argparse_free(&parser);
+}
+
+Test(errors, list_range_and_capacity, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "--ids", "1,2,2147483648"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 3, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int ids[3];
+    const char *names[2];
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION_LIST(INT, 'i', "--ids", ids, "ids", ',', 3),
+        ARGPARSE_OPTION_LIST(STRING, 'n', "--names", names, "names", ',', 2)};
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &args[1])),
+                 ARGPARSE_UNSUPPORTED_ACTION_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &args[0])),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_INT_RANGE_EXCEEDED_ERROR);
+
+    argparse_reset(&parser);
+    char *overlong[] = {"--ids", "123456789012345678901234567890"};
+    parser.argc_ = 2;
+    parser.argv_ = overlong;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_INT_RANGE_EXCEEDED_ERROR);
+
+    argparse_reset(&parser);
+    char *too_many[] = {"--ids", "1,2,3,4"};
+    parser.argv_ = too_many;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_CAPACITY_EXCEEDED_ERROR);
+
+    // empty elements and lone signs are not converted to 0
+    char *empty[][2] = {{"--ids", "010,,7"}, {"--ids", "1,2,"}, {"--ids", ""},
+                        {"--ids", "1,-,3"}};
+    for (size_t i = 0; i < 4; i++) {
+        argparse_reset(&parser);
+        parser.argv_ = empty[i];
+        cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                     ARGPARSE_INVALID_VALUE_ERROR);
+    }
+    argparse_free(&parser);
+}
+
+// APPEND
+Test(argparse, append_occurrences, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-I", "a", "--include", "b", "-Ic",
+                    "-q", "-n", "1", "-n", "-2"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 11, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    const char *dirs[4] = {NULL};
+    int nums[2];
+    bool quiet = false;
+    argparse_arg_t args[] = {
+        ARGPARSE_APPEND(STRING, 'I', "--include", dirs, "include", 4),
+        ARGPARSE_APPEND(INT, 'n', "--num", nums, "numbers", 2),
+        ARGPARSE_FLAG_TRUE('q', "--quiet", &quiet, "quiet")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 3)),
+                 ARGPARSE_NO_ERROR);
+
+    if (TESTS_PRINT_HELP)
+        argparse_print_help(&parser);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(args[0].count_, 3);
+    cr_assert_str_eq(dirs[0], "a");
+    cr_assert_str_eq(dirs[1], "b");
+    cr_assert_str_eq(dirs[2], "c");
+    cr_assert_null(dirs[3]);
+    cr_assert_eq(quiet, true);
+    cr_assert_eq(args[1].count_, 2);
+    cr_assert_eq(nums[0], 1);
+    cr_assert_eq(nums[1], -2);
+    argparse_free(&parser);
+}
+
+Test(errors, append_capacity_exceeded, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-n", "1", "-n", "2", "-n", "3"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 7, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int nums[2];
+    bool flags[2];
+    argparse_arg_t args[] = {
+        ARGPARSE_APPEND(INT, 'n', "--num", nums, "numbers", 2),
+        ARGPARSE_APPEND(INT, 'm', "--more", nums, "no capacity", 0),
+        ARGPARSE_APPEND(BOOL, 'b', "--bool", flags, "bools", 2)};
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &args[1])),
+                 ARGPARSE_UNSUPPORTED_ACTION_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &args[2])),
+                 ARGPARSE_UNSUPPORTED_ACTION_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &args[0])),
+                 ARGPARSE_NO_ERROR);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_CAPACITY_EXCEEDED_ERROR);
+    cr_assert_eq(args[0].count_, 2);
+    cr_assert_eq(nums[1], 2);
+    argparse_free(&parser);
+}
+
+// DICTIONARIES
+Test(argparse, dict_pairs_and_policies, .init = newlines) {
+    argument_parser_t parser;
+
+    static char pairs[100][16];
+    char *argv[2 * 100 + 1] = {"./prog"};
+    int argc = 1;
+    for (int k = 0; k < 100; k++) {
+        snprintf(pairs[k], sizeof(pairs[k]), "key%d=%d", k, k * k);
+        argv[argc++] = "-D";
+        argv[argc++] = pairs[k];
+    }
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, argc, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    argparse_dict_t defines = {.policy_ = ARGPARSE_DICT_LAST_WINS};
+    argparse_arg_t arg = ARGPARSE_DICT('D', "--define", &defines, "defines");
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &arg)),
+                 ARGPARSE_NO_ERROR);
+
+    if (TESTS_PRINT_HELP)
+        argparse_print_help(&parser);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(defines.num_entries_, 100);
+    for (int k = 0; k < 100; k++) {
+        char key[16], value[16];
+        snprintf(key, sizeof(key), "key%d", k);
+        snprintf(value, sizeof(value), "%d", k * k);
+        cr_assert_str_eq(argparse_dict_get(&defines, key), value);
+        cr_assert_eq(defines.entries_[k].key_, pairs[k]);
+        cr_assert_eq(defines.entries_[k].key_len_, strlen(key));
+    }
+    cr_assert_null(argparse_dict_get(&defines, "key100"));
+
+    argparse_reset(&parser);
+    cr_assert_eq(defines.num_entries_, 0);
+    cr_assert_null(argparse_dict_get(&defines, "key1"));
+
+    char *repeated[] = {"-D", "a=1", "-D", "b=", "-D", "a=2"};
+    parser.argc_ = 6;
+    parser.argv_ = repeated;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_str_eq(argparse_dict_get(&defines, "a"), "2");
+    cr_assert_str_eq(argparse_dict_get(&defines, "b"), "");
+
+    argparse_reset(&parser);
+    defines.policy_ = ARGPARSE_DICT_FIRST_WINS;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_str_eq(argparse_dict_get(&defines, "a"), "1");
+    cr_assert_eq(defines.num_entries_, 2);
+
+    argparse_reset(&parser);
+    defines.policy_ = ARGPARSE_DICT_REJECT;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_DUPLICATE_KEY_ERROR);
+
+    argparse_reset(&parser);
+    defines.policy_ = ARGPARSE_DICT_LAST_WINS;
+    repeated[3] = "b";
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_INVALID_VALUE_ERROR);
+    argparse_free(&parser);
+}
+
+// LAZY CONVERSION
+Test(argparse, lazy_convert_on_access, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-t", "8", "--ratio", "0.5", "--mode", "slow",
+                    "-q", "--big", "99999999999", "routes.txt"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 11, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.lazy_ = true;
+
+    int threads = 1, big = 0, unused = 3;
+    float ratio = 0.0f;
+    bool quiet = false;
+    const char *mode = "fast", *file = NULL;
+    const char *modes[] = {"fast", "slow"};
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(INT, 't', "--threads", &threads, "threads"),
+        ARGPARSE_OPTION(FLOAT, 'r', "--ratio", &ratio, "ratio"),
+        ARGPARSE_OPTION_WITH_CHOICES(STRING, 'm', "--mode", &mode, "mode",
+                                     modes, 2),
+        ARGPARSE_FLAG_TRUE('q', "--quiet", &quiet, "quiet"),
+        ARGPARSE_OPTION(INT, 'b', "--big", &big, "big"),
+        ARGPARSE_OPTION(INT, 'u', "--unused", &unused, "unused"),
+        ARGPARSE_POSITIONAL(STRING, "file", &file, "file")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 7)),
+                 ARGPARSE_NO_ERROR);
+
+    // the out-of-range value is only reported when it is accessed
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(threads, 1);
+    cr_assert_str_eq(args[0].raw_, "8");
+    cr_assert_eq(quiet, true);
+
+    int out_int = 0;
+    cr_assert_eq(argparse_check_error(
+                     argparse_get_int(&parser, "--threads", &out_int)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(out_int, 8);
+    cr_assert_eq(threads, 8);
+    cr_assert_null(args[0].raw_);
+    cr_assert_eq(
+        argparse_check_error(argparse_get_int(&parser, "-t", &out_int)),
+        ARGPARSE_NO_ERROR);
+    cr_assert_eq(out_int, 8);
+
+    float out_float = 0.0f;
+    cr_assert_eq(argparse_check_error(
+                     argparse_get_float(&parser, "ratio", &out_float)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_float_eq(out_float, 0.5f, 1e-6);
+
+    const char *out_string = NULL;
+    cr_assert_eq(argparse_check_error(
+                     argparse_get_string(&parser, "--mode", &out_string)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_str_eq(out_string, "slow");
+    cr_assert_eq(argparse_check_error(
+                     argparse_get_string(&parser, "file", &out_string)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_str_eq(out_string, "routes.txt");
+
+    bool out_bool = false;
+    cr_assert_eq(argparse_check_error(
+                     argparse_get_bool(&parser, "--quiet", &out_bool)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(out_bool, true);
+
+    cr_assert_eq(argparse_check_error(
+                     argparse_get_int(&parser, "--unused", &out_int)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(out_int, 3);
+
+    cr_assert_eq(argparse_check_error(
+                     argparse_get_int(&parser, "--big", &out_int)),
+                 ARGPARSE_INT_RANGE_EXCEEDED_ERROR);
+    cr_assert_eq(argparse_check_error(
+                     argparse_get_int(&parser, "--ratio", &out_int)),
+                 ARGPARSE_TYPE_MISMATCH_ERROR);
+    cr_assert_eq(argparse_check_error(
+                     argparse_get_int(&parser, "--missing", &out_int)),
+                 ARGPARSE_ARGUMENT_UNKNOWN_ERROR);
+
+    argparse_reset(&parser);
+    cr_assert_eq(threads, 1);
+    cr_assert_null(args[4].raw_);
+    argparse_free(&parser);
+}
+
+Test(errors, lazy_invalid_choice_on_access, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "--mode", "medium"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 3, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    parser.lazy_ = true;
+
+    const char *mode = "fast";
+    const char *modes[] = {"fast", "slow"};
+    argparse_arg_t arg = ARGPARSE_OPTION_WITH_CHOICES(
+        STRING, 'm', "--mode", &mode, "mode", modes, 2);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &arg)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+
+    const char *out = NULL;
+    cr_assert_eq(
+        argparse_check_error(argparse_get_string(&parser, "--mode", &out)),
+        ARGPARSE_INVALID_CHOICE_ERROR);
+    cr_assert_str_eq(mode, "fast");
+    argparse_free(&parser);
+}
+
+// CALLBACKS
+typedef struct {
+    int calls;
+    int sum;
+    const char *last_token;
+} callback_log_t;
+
+static int sum_callback(argparse_arg_t *arg, const char *token,
+                        const void *value, void *context) {
+    (void)arg;
+    callback_log_t *log = context;
+    log->calls++;
+    log->sum += *(const int *)value;
+    log->last_token = token;
+    return 0;
+}
+
+static int record_callback(argparse_arg_t *arg, const char *token,
+                           const void *value, void *context) {
+    callback_log_t *log = context;
+    log->calls++;
+    log->last_token = token;
+    // the value is stored before the callback runs
+    return strcmp(*(const char *const *)arg->value_,
+                  *(const char *const *)value) != 0;
+}
+
+static int reject_large(argparse_arg_t *arg, const char *token,
+                        const void *value, void *context) {
+    (void)arg;
+    (void)token;
+    (void)context;
+    // a distinct status, which the error carries back to the caller
+    return *(const int *)value > 10 ? 7 : 0;
+}
+
+Test(argparse, callback_invoked_inline, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-n", "3", "--label", "a", "--num", "16"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 7, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    callback_log_t num_log = {0, 0, NULL};
+    callback_log_t label_log = {0, 0, NULL};
+    const char *label = "none";
+    argparse_arg_t args[] = {
+        ARGPARSE_CALLBACK(INT, 'n', "--num", NULL, "add a number",
+                          sum_callback, &num_log),
+        ARGPARSE_CALLBACK(STRING, 'l', "--label", &label, "label",
+                          record_callback, &label_log),
+    };
+    for (size_t i = 0; i < sizeof(args) / sizeof(args[0]); i++) {
+        cr_assert_eq(
+            argparse_check_error(argparse_add_argument(&parser, &args[i])),
+            ARGPARSE_NO_ERROR);
+    }
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+
+    cr_assert_eq(num_log.calls, 2);
+    cr_assert_eq(num_log.sum, 19);
+    cr_assert_str_eq(num_log.last_token, "16");
+    cr_assert_eq(label_log.calls, 1);
+    cr_assert_str_eq(label, "a");
+
+    // a callback without a destination has no value to read
+    int num = 0;
+    cr_assert_eq(argparse_check_error(argparse_get_int(&parser, "--num", &num)),
+                 ARGPARSE_TYPE_MISMATCH_ERROR);
+    const char *got = NULL;
+    cr_assert_eq(
+        argparse_check_error(argparse_get_string(&parser, "--label", &got)),
+        ARGPARSE_NO_ERROR);
+    cr_assert_str_eq(got, "a");
+
+    argparse_reset(&parser);
+    cr_assert_str_eq(label, "none");
+    argparse_free(&parser);
+}
+
+Test(errors, callback_failure_stops_parsing, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-n", "5", "-n", "12", "-n", "1"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 7, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    argparse_arg_t missing = ARGPARSE_CALLBACK(INT, 'm', "--missing", NULL,
+                                               "no callback", NULL, NULL);
+    cr_assert_eq(
+        argparse_check_error(argparse_add_argument(&parser, &missing)),
+        ARGPARSE_UNSUPPORTED_ACTION_ERROR);
+
+    int num = 0;
+    argparse_arg_t arg = ARGPARSE_CALLBACK(INT, 'n', "--num", &num,
+                                           "small number", reject_large, NULL);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &arg)),
+                 ARGPARSE_NO_ERROR);
+    argparse_error_t error = argparse_parse_args(&parser);
+    cr_assert_eq(argparse_check_error(error), ARGPARSE_CALLBACK_ERROR);
+    cr_assert_eq(error.callback_status, 7);
+    cr_assert_eq(num, 12);
+    argparse_free(&parser);
+}
+
+// KNOWN ARGS
+Test(argparse, known_args_collects_unknown, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "in.txt", "--color", "auto", "-v",
+                    "--jobs", "4",      "-x"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 8, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    bool verbose = false;
+    const char *file = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_FLAG_TRUE('v', "--verbose", &verbose, "verbose"),
+        ARGPARSE_POSITIONAL(STRING, "file", &file, "input file"),
+    };
+    for (size_t i = 0; i < sizeof(args) / sizeof(args[0]); i++) {
+        cr_assert_eq(
+            argparse_check_error(argparse_add_argument(&parser, &args[i])),
+            ARGPARSE_NO_ERROR);
+    }
+
+    int unknown[8];
+    size_t num_unknown = 0;
+    cr_assert_eq(argparse_check_error(argparse_parse_known_args(
+                     &parser, unknown, 8, &num_unknown)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(verbose, true);
+    cr_assert_str_eq(file, "in.txt");
+
+    int expected[] = {1, 2, 4, 5, 6};
+    cr_assert_eq(num_unknown, 5);
+    for (size_t i = 0; i < num_unknown; i++) {
+        cr_assert_eq(unknown[i], expected[i]);
+    }
+    cr_assert_eq(parser.argv_[unknown[1]], argv[3]);
+    argparse_free(&parser);
+}
+
+Test(argparse, known_args_keeps_unknown_groups, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-vX", "-vo", "out", "--zz"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 5, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int verbosity = 0;
+    const char *output = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_COUNT('v', "--verbose", &verbosity, "verbosity"),
+        ARGPARSE_OPTION(STRING, 'o', "--output", &output, "output file"),
+    };
+    for (size_t i = 0; i < sizeof(args) / sizeof(args[0]); i++) {
+        cr_assert_eq(
+            argparse_check_error(argparse_add_argument(&parser, &args[i])),
+            ARGPARSE_NO_ERROR);
+    }
+
+    // the group with an unknown flag is forwarded without applying -v
+    int unknown[4];
+    size_t num_unknown = 0;
+    cr_assert_eq(argparse_check_error(argparse_parse_known_args(
+                     &parser, unknown, 4, &num_unknown)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(verbosity, 1);
+    cr_assert_str_eq(output, "out");
+    cr_assert_eq(num_unknown, 2);
+    cr_assert_eq(unknown[0], 0);
+    cr_assert_eq(unknown[1], 3);
+    argparse_free(&parser);
+}
+
+Test(errors, known_args_capacity_exceeded, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "--first", "--second"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 3, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int unknown[1];
+    size_t num_unknown = 0;
+    cr_assert_eq(argparse_check_error(argparse_parse_known_args(
+                     &parser, unknown, 1, &num_unknown)),
+                 ARGPARSE_CAPACITY_EXCEEDED_ERROR);
+    cr_assert_eq(num_unknown, 1);
+    cr_assert_eq(unknown[0], 0);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_ARGUMENT_UNKNOWN_ERROR);
+    argparse_free(&parser);
+}
+
+// REMAINDER
+Test(argparse, terminator_ends_options, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "--", "-v", "--name"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 4, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    bool verbose = false;
+    const char *first = NULL, *second = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_FLAG_TRUE('v', "--verbose", &verbose, "verbose"),
+        ARGPARSE_POSITIONAL(STRING, "first", &first, "first"),
+        ARGPARSE_POSITIONAL(STRING, "second", &second, "second"),
+    };
+    for (size_t i = 0; i < sizeof(args) / sizeof(args[0]); i++) {
+        cr_assert_eq(
+            argparse_check_error(argparse_add_argument(&parser, &args[i])),
+            ARGPARSE_NO_ERROR);
+    }
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(verbose, false);
+    cr_assert_str_eq(first, "-v");
+    cr_assert_str_eq(second, "--name");
+    argparse_free(&parser);
+}
+
+Test(argparse, terminator_values_into_nargs, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-v", "--", "-a", "-b", "--"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 6, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    bool verbose = false;
+    const char **files = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_FLAG_TRUE('v', "--verbose", &verbose, "verbose"),
+        ARGPARSE_POSITIONAL_NARGS(STRING, "files", &files, "files",
+                                  ONE_OR_MORE, 0),
+    };
+    for (size_t i = 0; i < sizeof(args) / sizeof(args[0]); i++) {
+        cr_assert_eq(
+            argparse_check_error(argparse_add_argument(&parser, &args[i])),
+            ARGPARSE_NO_ERROR);
+    }
+
+    // after '--', values starting with '-' belong to the positional
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(verbose, true);
+    cr_assert_eq(args[1].num_values_, 3);
+    cr_assert_str_eq(files[0], "-a");
+    cr_assert_str_eq(files[1], "-b");
+    cr_assert_str_eq(files[2], "--");
+
+    argparse_reset(&parser);
+    args[1].nargs_ = ZERO_OR_MORE;
+    char *argv2[] = {"--", "-x"};
+    parser.argc_ = 2;
+    parser.argv_ = argv2;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(args[1].num_values_, 1);
+    cr_assert_str_eq(files[0], "-x");
+    argparse_free(&parser);
+}
+
+Test(argparse, remainder_takes_argv_tail, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-v", "make", "-j", "4", "--", "all"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 7, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    bool verbose = false;
+    char **command = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_FLAG_TRUE('v', "--verbose", &verbose, "verbose"),
+        ARGPARSE_REMAINDER("command", &command, "command to run"),
+    };
+    for (size_t i = 0; i < sizeof(args) / sizeof(args[0]); i++) {
+        cr_assert_eq(
+            argparse_check_error(argparse_add_argument(&parser, &args[i])),
+            ARGPARSE_NO_ERROR);
+    }
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(verbose, true);
+    cr_assert_eq(command, &argv[2]);
+    cr_assert_eq(args[1].num_values_, 5);
+    cr_assert_str_eq(command[4], "all");
+
+    argparse_reset(&parser);
+    cr_assert_null(command);
+
+    char *argv2[] = {"./prog", "--", "-v"};
+    parser.argc_ = 2;
+    parser.argv_ = argv2 + 1;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(verbose, false);
+    cr_assert_eq(command, &argv2[2]);
+    cr_assert_eq(args[1].num_values_, 1);
+
+    argparse_arg_t option = ARGPARSE_ARG(STRING, 'r', "--rest", &command,
+                                         ARGPARSE_STORE_ACTION, "rest",
+                                         OPTIONAL, NO_CHOICES, 0, NULL, 0, 0,
+                                         REMAINDER, 0);
+    cr_assert_eq(
+        argparse_check_error(argparse_add_argument(&parser, &option)),
+        ARGPARSE_UNSUPPORTED_ACTION_ERROR);
+
+    // only argv provides the NULL terminator of the remainder
+    argparse_reset(&parser);
+    char line[] = "{\"command\": \"make\"}";
+    cr_assert_eq(argparse_check_error(
+                     argparse_parse_json_line(&parser, line, strlen(line))),
+                 ARGPARSE_INVALID_JSON_ERROR);
+    argparse_free(&parser);
+}
+
+// ATTACHED VALUES
+Test(argparse, attached_long_and_short_forms, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "--threads=8", "-vo", "out.txt",
+                    "-Ofast", "--label=",    "-n=3"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 7, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int threads = 1;
+    bool verbose = false;
+    const char *output = NULL, *opt = NULL, *label = "none", *n = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(INT, 't', "--threads", &threads, "threads"),
+        ARGPARSE_FLAG_TRUE('v', "--verbose", &verbose, "verbose"),
+        ARGPARSE_OPTION(STRING, 'o', "--output", &output, "output"),
+        ARGPARSE_OPTION(STRING, 'O', "--optimise", &opt, "optimisation"),
+        ARGPARSE_OPTION(STRING, 'l', "--label", &label, "label"),
+        ARGPARSE_OPTION(STRING, 'n', "--name", &n, "name"),
+    };
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 6)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+
+    cr_assert_eq(threads, 8);
+    cr_assert_eq(verbose, true);
+    cr_assert_str_eq(output, "out.txt");
+    cr_assert_eq(opt, argv[4] + 2);
+    cr_assert_str_eq(label, "");
+    cr_assert_str_eq(n, "=3");
+    cr_assert_str_eq(argv[1], "--threads=8");
+    argparse_free(&parser);
+}
+
+Test(errors, attached_unexpected_value, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "--verbose=1"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 2, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    bool verbose = false;
+    argparse_arg_t arg =
+        ARGPARSE_FLAG_TRUE('v', "--verbose", &verbose, "verbose");
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &arg)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_UNEXPECTED_VALUE_ERROR);
+
+    char *argv2[] = {"--verb=1"};
+    parser.argc_ = 1;
+    parser.argv_ = argv2;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_ARGUMENT_UNKNOWN_ERROR);
+    argparse_free(&parser);
+}
+
+// SUBCOMMANDS
+typedef struct {
+    int jobs;
+    const char *target;
+    int init_calls;
+    argparse_arg_t args[2];
+} build_command_t;
+
+static argparse_error_t build_init(argument_parser_t *parser, void *context) {
+    build_command_t *build = context;
+    build->init_calls++;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(INT, 'j', "--jobs", &build->jobs, "parallel jobs"),
+        ARGPARSE_POSITIONAL(STRING, "target", &build->target, "target"),
+    };
+    memcpy(build->args, args, sizeof(args));
+    return argparse_add_arguments(parser, build->args, 2);
+}
+
+static argparse_error_t clean_init(argument_parser_t *parser, void *context) {
+    (*(int *)context)++;
+    return argparse_add_arguments(parser, NULL, 0);
+}
+
+Test(argparse, subcommand_lazily_built, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-v", "build", "-j4", "all"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 5, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    bool verbose = false;
+    argparse_arg_t arg =
+        ARGPARSE_FLAG_TRUE('v', "--verbose", &verbose, "verbose");
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &arg)),
+                 ARGPARSE_NO_ERROR);
+
+    build_command_t build = {.jobs = 1, .target = NULL, .init_calls = 0};
+    int clean_calls = 0;
+    argparse_subcommand_t cmds[] = {
+        ARGPARSE_SUBCOMMAND("build", build_init, &build, "build a target"),
+        ARGPARSE_SUBCOMMAND("clean", clean_init, &clean_calls, "clean up"),
+    };
+    for (size_t i = 0; i < 2; i++) {
+        cr_assert_eq(
+            argparse_check_error(argparse_add_subcommand(&parser, &cmds[i])),
+            ARGPARSE_NO_ERROR);
+    }
+
+    if (TESTS_PRINT_HELP)
+        argparse_print_help(&parser);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(verbose, true);
+    cr_assert_eq(parser.subcommand_, &cmds[0]);
+    cr_assert_str_eq(parser.subparser_->prog_, "./prog build");
+    cr_assert_eq(build.init_calls, 1);
+    cr_assert_eq(clean_calls, 0);
+    cr_assert_eq(build.jobs, 4);
+    cr_assert_str_eq(build.target, "all");
+
+    argparse_reset(&parser);
+    cr_assert_null(parser.subcommand_);
+    cr_assert_null(parser.subparser_);
+    cr_assert_eq(build.jobs, 1);
+    cr_assert_eq(verbose, false);
+    argparse_free(&parser);
+}
+
+Test(argparse, subcommand_after_positionals, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "proj", "build", "-j", "4", "all"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 6, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    const char *project = NULL;
+    argparse_arg_t arg =
+        ARGPARSE_POSITIONAL(STRING, "project", &project, "project");
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &arg)),
+                 ARGPARSE_NO_ERROR);
+
+    build_command_t build = {.jobs = 1, .target = NULL, .init_calls = 0};
+    argparse_subcommand_t cmd =
+        ARGPARSE_SUBCOMMAND("build", build_init, &build, "build a target");
+    cr_assert_eq(argparse_check_error(argparse_add_subcommand(&parser, &cmd)),
+                 ARGPARSE_NO_ERROR);
+
+    if (TESTS_PRINT_HELP)
+        argparse_print_help(&parser);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_str_eq(project, "proj");
+    cr_assert_eq(parser.subcommand_, &cmd);
+    cr_assert_eq(build.jobs, 4);
+    cr_assert_str_eq(build.target, "all");
+    argparse_free(&parser);
+}
+
+Test(argparse, subcommand_unknown_and_known_args, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "build", "-j4", "t", "--extra", "x"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 6, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    build_command_t build = {.jobs = 1, .target = NULL, .init_calls = 0};
+    argparse_subcommand_t cmd =
+        ARGPARSE_SUBCOMMAND("build", build_init, &build, "build a target");
+    cr_assert_eq(argparse_check_error(argparse_add_subcommand(&parser, &cmd)),
+                 ARGPARSE_NO_ERROR);
+    argparse_subcommand_t dup =
+        ARGPARSE_SUBCOMMAND("build", build_init, &build, "duplicate");
+    cr_assert_eq(argparse_check_error(argparse_add_subcommand(&parser, &dup)),
+                 ARGPARSE_CONFLICTING_OPTIONS_ERROR);
+
+    int unknown[4];
+    size_t num_unknown = 0;
+    cr_assert_eq(argparse_check_error(argparse_parse_known_args(
+                     &parser, unknown, 4, &num_unknown)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(num_unknown, 2);
+    cr_assert_eq(unknown[0], 3);
+    cr_assert_eq(unknown[1], 4);
+    cr_assert_str_eq(build.target, "t");
+    argparse_reset(&parser);
+
+    char *argv2[] = {"install"};
+    parser.argc_ = 1;
+    parser.argv_ = argv2;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_INVALID_CHOICE_ERROR);
+    argparse_free(&parser);
+}
+
+// PARENTS
+Test(argparse, parents_shared_by_parsers, .init = newlines) {
+    int level = 0;
+    const char *trace = NULL;
+    const argparse_arg_t logging[] = {
+        ARGPARSE_COUNT('v', "--verbose", &level, "verbosity"),
+        ARGPARSE_OPTION(STRING, 't', "--trace", &trace, "trace file"),
+    };
+
+    argument_parser_t first, second;
+    char *argv1[] = {"./first", "-vv", "--trace", "out.json"};
+    char *argv2[] = {"./second", "-j", "2", "-v"};
+    cr_assert_eq(argparse_check_error(argparse_init(
+                     &first, 4, argv1, NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_init(
+                     &second, 4, argv2, NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int jobs = 1;
+    argparse_arg_t arg = ARGPARSE_OPTION(INT, 'j', "--jobs", &jobs, "jobs");
+    cr_assert_eq(
+        argparse_check_error(argparse_add_parent(&first, logging, 2)),
+        ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&second, &arg)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(
+        argparse_check_error(argparse_add_parent(&second, logging, 2)),
+        ARGPARSE_NO_ERROR);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&first)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(level, 2);
+    cr_assert_str_eq(trace, "out.json");
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&second)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(level, 1);
+    cr_assert_eq(jobs, 2);
+
+    // the shared specification is never written
+    cr_assert_null(logging[0].next_);
+    cr_assert_eq(logging[0].count_, 0);
+    cr_assert_eq(logging[1].touched_, false);
+    cr_assert_neq(first.options_, &logging[0]);
+    argparse_free(&first);
+    argparse_free(&second);
+}
+
+Test(errors, parents_conflicting, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 1, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int level = 0;
+    const argparse_arg_t logging[] = {
+        ARGPARSE_COUNT('v', "--verbose", &level, "verbosity"),
+    };
+    cr_assert_eq(
+        argparse_check_error(argparse_add_parent(&parser, logging, 1)),
+        ARGPARSE_NO_ERROR);
+    cr_assert_eq(
+        argparse_check_error(argparse_add_parent(&parser, logging, 1)),
+        ARGPARSE_CONFLICTING_OPTIONS_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_add_parent(&parser, NULL, 0)),
+                 ARGPARSE_NO_ERROR);
+
+    // an argument added directly belongs to one parser until it is freed
+    argument_parser_t other;
+    cr_assert_eq(argparse_check_error(argparse_init(&other, 1, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+    bool quiet = false;
+    argparse_arg_t args[] = {
+        ARGPARSE_FLAG_TRUE('q', "--quiet", &quiet, "quiet"),
+        ARGPARSE_FLAG_TRUE('Q', "--silent", &quiet, "silent")};
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+    for (size_t i = 0; i < 2; i++) {
+        cr_assert_eq(
+            argparse_check_error(argparse_add_argument(&other, &args[i])),
+            ARGPARSE_CONFLICTING_OPTIONS_ERROR);
+    }
+    cr_assert_not_null(args[0].next_);
+
+    argparse_free(&parser);
+    cr_assert_null(args[0].next_);
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&other, args, 2)),
+                 ARGPARSE_NO_ERROR);
+    argparse_free(&other);
+}
+
+// ARGUMENT RULES
+Test(argparse, exclusive_groups, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "--json", "-y"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 3, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    bool json = false, yaml = false, quiet = false;
+    argparse_arg_t args[] = {
+        ARGPARSE_FLAG_TRUE('j', "--json", &json, "json output"),
+        ARGPARSE_FLAG_TRUE('y', "--yaml", &yaml, "yaml output"),
+        ARGPARSE_FLAG_TRUE('q', "--quiet", &quiet, "quiet"),
+    };
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 3)),
+                 ARGPARSE_NO_ERROR);
+    const char *formats[] = {"json", "-y"};
+    cr_assert_eq(argparse_check_error(
+                     argparse_add_exclusive_group(&parser, formats, 2, true)),
+                 ARGPARSE_NO_ERROR);
+    const char *unknown[] = {"--xml"};
+    cr_assert_eq(argparse_check_error(
+                     argparse_add_exclusive_group(&parser, unknown, 1, false)),
+                 ARGPARSE_ARGUMENT_UNKNOWN_ERROR);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_CONFLICTING_OPTIONS_ERROR);
+    argparse_reset(&parser);
+
+    char *argv2[] = {"--yaml", "-q"};
+    parser.argc_ = 2;
+    parser.argv_ = argv2;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(yaml, true);
+    cr_assert_eq(json, false);
+    argparse_reset(&parser);
+
+    parser.argc_ = 1;
+    parser.argv_ = argv2 + 1;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_MISSING_ARGUMENT_ERROR);
+    argparse_free(&parser);
+}
+
+Test(argparse, requires_across_words, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "--user", "admin", "--opt129", "1"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 5, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    // enough options to span three words of the bitsets
+    static char names[130][10];
+    static argparse_arg_t opts[130];
+    int values[130] = {0};
+    for (int i = 0; i < 130; i++) {
+        snprintf(names[i], sizeof(names[i]), "--opt%d", i);
+        ARGPARSE_ARG_INIT(&opts[i], INT, '\0', names[i], &values[i],
+                          ARGPARSE_STORE_ACTION, "option", i == 129);
+    }
+    cr_assert_eq(
+        argparse_check_error(argparse_add_arguments(&parser, opts, 130)),
+        ARGPARSE_NO_ERROR);
+
+    const char *user = NULL, *password = NULL;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(STRING, 'u', "--user", &user, "user"),
+        ARGPARSE_OPTION(STRING, 'p', "--password", &password, "password"),
+    };
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+    const char *needs[] = {"password", "--opt129"};
+    cr_assert_eq(argparse_check_error(
+                     argparse_add_requires(&parser, "--user", needs, 2)),
+                 ARGPARSE_NO_ERROR);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_MISSING_ARGUMENT_ERROR);
+    argparse_reset(&parser);
+
+    char *argv2[] = {"-uadmin", "-psecret", "--opt129=2"};
+    parser.argc_ = 3;
+    parser.argv_ = argv2;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(values[129], 2);
+    argparse_reset(&parser);
+
+    char *argv3[] = {"--opt5", "3"};
+    parser.argc_ = 2;
+    parser.argv_ = argv3;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_MISSING_ARGUMENT_ERROR);
+    argparse_free(&parser);
+}
+
+// BOUNDS
+Test(argparse, bounds_inclusive_range, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-t", "0"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 3, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int threads = 4;
+    argparse_arg_t arg = ARGPARSE_OPTION_RANGE(INT, 't', "--threads", &threads,
+                                               "worker threads", 1, 64);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &arg)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_OUT_OF_BOUNDS_ERROR);
+    cr_assert_eq(threads, 4);
+    argparse_reset(&parser);
+
+    char *argv2[] = {"--threads=64"};
+    parser.argc_ = 1;
+    parser.argv_ = argv2;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(threads, 64);
+
+    const char *name = NULL;
+    argparse_arg_t string = ARGPARSE_OPTION_RANGE(STRING, 'n', "--name", &name,
+                                                  "name", 0, 1);
+    cr_assert_eq(
+        argparse_check_error(argparse_add_argument(&parser, &string)),
+        ARGPARSE_UNSUPPORTED_ACTION_ERROR);
+    argparse_free(&parser);
+}
+
+Test(argparse, bounds_exclusive_float_and_lists, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-r", "0"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 3, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    float ratio = 0.5f;
+    int ports[4];
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(FLOAT, 'r', "--ratio", &ratio, "ratio"),
+        ARGPARSE_OPTION_LIST(INT, 'p', "--ports", ports, "ports", ',', 4),
+    };
+    args[0].bounds_ = ARGPARSE_MIN_EXCLUSIVE | ARGPARSE_MAX_INCLUSIVE;
+    args[0].min_ = 0;
+    args[0].max_ = 1;
+    args[1].bounds_ = ARGPARSE_MIN_INCLUSIVE | ARGPARSE_MAX_EXCLUSIVE;
+    args[1].min_ = 1;
+    args[1].max_ = 65536;
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_OUT_OF_BOUNDS_ERROR);
+    argparse_reset(&parser);
+
+    char *argv2[] = {"-r", "nan"};
+    parser.argc_ = 2;
+    parser.argv_ = argv2;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_OUT_OF_BOUNDS_ERROR);
+    argparse_reset(&parser);
+
+    char *argv3[] = {"-r", "1", "-p", "80,443,65536"};
+    parser.argc_ = 4;
+    parser.argv_ = argv3;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_OUT_OF_BOUNDS_ERROR);
+    cr_assert_float_eq(ratio, 1.0f, 1e-6);
+    argparse_reset(&parser);
+
+    char *argv4[] = {"-p", "80,443,65535"};
+    parser.argc_ = 2;
+    parser.argv_ = argv4;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(ports[2], 65535);
+    argparse_free(&parser);
+}
+
+// ENUMS
+Test(argparse, enum_maps_choices_to_indices, .init = newlines) {
+    argument_parser_t parser;
+
+    static const char *levels[] = {
+        "trace", "debug", "info",  "notice", "warn",  "error", "fatal",
+        "alert", "emerg", "quiet", "silent", "loud",  "audit", "perf",
+        "dump",  "none",  "all",   "user",   "local", "kern",  "mail",
+    };
+    size_t num_levels = sizeof(levels) / sizeof(*levels);
+
+    char *argv[] = {"./prog", "-l", "info"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 3, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int level = -1;
+    argparse_arg_t arg = ARGPARSE_OPTION_ENUM('l', "--level", &level, "level",
+                                              levels, num_levels);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &arg)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(level, 2);
+
+    // every choice resolves to its own index
+    for (size_t i = 0; i < num_levels; i++) {
+        argparse_reset(&parser);
+        char *argv2[] = {"--level", (char *)levels[i]};
+        parser.argc_ = 2;
+        parser.argv_ = argv2;
+        cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                     ARGPARSE_NO_ERROR);
+        cr_assert_eq(level, (int)i);
+    }
+    argparse_reset(&parser);
+    cr_assert_eq(level, -1);
+
+    char *argv3[] = {"-l", "infos"};
+    parser.argc_ = 2;
+    parser.argv_ = argv3;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_INVALID_CHOICE_ERROR);
+    argparse_reset(&parser);
+
+    // in lazy mode the choice is resolved by the int accessor
+    parser.lazy_ = true;
+    char *argv4[] = {"-l", "kern"};
+    parser.argv_ = argv4;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    int out = -1;
+    cr_assert_eq(
+        argparse_check_error(argparse_get_int(&parser, "--level", &out)),
+        ARGPARSE_NO_ERROR);
+    cr_assert_eq(out, 19);
+    argparse_free(&parser);
+}
+
+Test(errors, enum_invalid_choices, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "fast", "slow", "fast"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 4, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    const char *repeated[] = {"a", "b", "a"};
+    int value;
+    argparse_arg_t dup = ARGPARSE_OPTION_ENUM('m', "--mode", &value, "mode",
+                                              repeated, 3);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &dup)),
+                 ARGPARSE_CONFLICTING_OPTIONS_ERROR);
+
+    argparse_arg_t none =
+        ARGPARSE_OPTION_ENUM('m', "--mode", &value, "mode", NULL, 0);
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &none)),
+                 ARGPARSE_UNSUPPORTED_CHOICES_ERROR);
+
+    enum speed { SPEED_SLOW, SPEED_FAST };
+    const char *speeds[] = {[SPEED_SLOW] = "slow", [SPEED_FAST] = "fast"};
+    int values[3];
+    argparse_arg_t arg =
+        ARGPARSE_POSITIONAL_NARGS(ENUM, "speeds", values, "speeds", 3, 3);
+    arg.choices_ = speeds;
+    arg.num_choices_ = 2;
+    cr_assert_eq(argparse_check_error(argparse_add_argument(&parser, &arg)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(values[0], SPEED_FAST);
+    cr_assert_eq(values[1], SPEED_SLOW);
+    cr_assert_eq(values[2], SPEED_FAST);
+    argparse_free(&parser);
+}
+
+// WIDE INTEGERS
+Test(argparse, wide_int_range_of_each_type, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-s", "-9223372036854775808", "-b",
+                    "18446744073709551615", "-m", "0xffffffff"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 7, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    int64_t seed = 0;
+    uint64_t bytes = 0;
+    uint32_t mask = 0;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(INT64, 's', "--seed", &seed, "seed"),
+        ARGPARSE_OPTION(UINT64, 'b', "--bytes", &bytes, "bytes"),
+        ARGPARSE_OPTION(UINT32, 'm', "--mask", &mask, "mask"),
+    };
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 3)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(seed, INT64_MIN);
+    cr_assert_eq(bytes, UINT64_MAX);
+    cr_assert_eq(mask, UINT32_MAX);
+    argparse_reset(&parser);
+    cr_assert_eq(seed, 0);
+
+    char *too_big[][2] = {{"-m", "4294967296"},
+                          {"-b", "18446744073709551616"},
+                          {"-b", "-1"},
+                          {"-s", "9223372036854775808"}};
+    for (size_t i = 0; i < 4; i++) {
+        parser.argc_ = 2;
+        parser.argv_ = too_big[i];
+        cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                     ARGPARSE_INT_RANGE_EXCEEDED_ERROR);
+        argparse_reset(&parser);
+    }
+
+    char *argv2[] = {"-s", "12abc"};
+    parser.argv_ = argv2;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_INVALID_VALUE_ERROR);
+    argparse_reset(&parser);
+
+    // in lazy mode the value is converted by its accessor
+    parser.lazy_ = true;
+    char *argv3[] = {"-b", "0x100000000"};
+    parser.argv_ = argv3;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    uint64_t out = 0;
+    cr_assert_eq(
+        argparse_check_error(argparse_get_uint64(&parser, "--bytes", &out)),
+        ARGPARSE_NO_ERROR);
+    cr_assert_eq(out, (uint64_t)1 << 32);
+    cr_assert_eq(
+        argparse_check_error(argparse_get_int(&parser, "--bytes", &(int){0})),
+        ARGPARSE_TYPE_MISMATCH_ERROR);
+    argparse_free(&parser);
+}
+
+Test(argparse, wide_int_choices_and_exact_bounds, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "-o", "9007199254740993"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 3, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    // 2^53 + 1 rounds to the bound as a double, but is compared exactly
+    int64_t offset = 0;
+    uint32_t page = 0;
+    uint32_t pages[] = {4096, 65536};
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION_RANGE(INT64, 'o', "--offset", &offset, "offset",
+                              -9007199254740992.0, 9007199254740992.0),
+        ARGPARSE_OPTION_WITH_CHOICES(UINT32, 'p', "--page", &page, "page",
+                                     pages, 2),
+    };
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_OUT_OF_BOUNDS_ERROR);
+    argparse_reset(&parser);
+
+    char *argv2[] = {"-o", "-9007199254740992", "-p", "65536"};
+    parser.argc_ = 4;
+    parser.argv_ = argv2;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(offset, -9007199254740992LL);
+    cr_assert_eq(page, 65536);
+    argparse_reset(&parser);
+
+    char *argv3[] = {"-p", "8192"};
+    parser.argc_ = 2;
+    parser.argv_ = argv3;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_INVALID_CHOICE_ERROR);
+    argparse_free(&parser);
+}
+
+// SIZES AND DURATIONS
+Test(argparse, units_scale_values, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog", "--cache", "512MiB", "--timeout", "250ms",
+                    "--rate", "10k"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 7, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    uint64_t cache = 0, timeout = 0, rate = 0;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION(SIZE, 'c', "--cache", &cache, "cache size"),
+        ARGPARSE_OPTION(DURATION, 't', "--timeout", &timeout, "timeout"),
+        ARGPARSE_OPTION(SIZE, 'r', "--rate", &rate, "rate"),
+    };
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 3)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    cr_assert_eq(cache, (uint64_t)512 << 20);
+    cr_assert_eq(timeout, 250000000);
+    cr_assert_eq(rate, 10000);
+    argparse_reset(&parser);
+
+    struct {
+        char *size;
+        uint64_t bytes;
+        char *duration;
+        uint64_t nanoseconds;
+    } cases[] = {
+        {"4096", 4096, "15ns", 15},
+        {"64B", 64, "3us", 3000},
+        {"2KiB", 2048, "1s", 1000000000},
+        {"3GB", 3000000000, "2m", 120000000000},
+        {"1Ti", (uint64_t)1 << 40, "5h", 18000000000000},
+        {"16777215TiB", (uint64_t)16777215 << 40, "0", 0},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+        char *argv2[] = {"-c", cases[i].size, "-t", cases[i].duration};
+        parser.argc_ = 4;
+        parser.argv_ = argv2;
+        cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                     ARGPARSE_NO_ERROR);
+        cr_assert_eq(cache, cases[i].bytes);
+        cr_assert_eq(timeout, cases[i].nanoseconds);
+        argparse_reset(&parser);
+    }
+
+    // durations are read with the unsigned 64-bit accessor in lazy mode
+    parser.lazy_ = true;
+    char *argv3[] = {"-t", "90s"};
+    parser.argc_ = 2;
+    parser.argv_ = argv3;
+    cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                 ARGPARSE_NO_ERROR);
+    uint64_t out = 0;
+    cr_assert_eq(
+        argparse_check_error(argparse_get_uint64(&parser, "--timeout", &out)),
+        ARGPARSE_NO_ERROR);
+    cr_assert_eq(out, 90000000000);
+    argparse_free(&parser);
+}
+
+Test(errors, units_invalid_values, .init = newlines) {
+    argument_parser_t parser;
+
+    char *argv[] = {"./prog"};
+    cr_assert_eq(argparse_check_error(argparse_init(&parser, 1, argv,
+                                                    NO_DESCRIPTION, NO_EPILOG)),
+                 ARGPARSE_NO_ERROR);
+
+    uint64_t size = 0, duration = 0;
+    argparse_arg_t args[] = {
+        ARGPARSE_OPTION_RANGE(SIZE, 's', "--size", &size, "size", 0, 1 << 30),
+        ARGPARSE_OPTION(DURATION, 'd', "--duration", &duration, "duration"),
+    };
+    cr_assert_eq(argparse_check_error(argparse_add_arguments(&parser, args, 2)),
+                 ARGPARSE_NO_ERROR);
+
+    struct {
+        char *arg;
+        char *value;
+        argparse_error_val error;
+    } cases[] = {
+        {"-s", "1GiB", ARGPARSE_NO_ERROR},
+        {"-s", "2GiB", ARGPARSE_OUT_OF_BOUNDS_ERROR},
+        {"-s", "10Pi", ARGPARSE_INVALID_VALUE_ERROR},
+        {"-s", "KiB", ARGPARSE_INVALID_VALUE_ERROR},
+        {"-s", "-1K", ARGPARSE_INT_RANGE_EXCEEDED_ERROR},
+        {"-d", "5", ARGPARSE_INVALID_VALUE_ERROR},
+        {"-d", "5sec", ARGPARSE_INVALID_VALUE_ERROR},
+        {"-d", "10msB", ARGPARSE_INVALID_VALUE_ERROR},
+        {"-d", "5124095h", ARGPARSE_NO_ERROR},
+        {"-d", "5124096h", ARGPARSE_INT_RANGE_EXCEEDED_ERROR},
+        {"-d", "18446744073709551616ns", ARGPARSE_INT_RANGE_EXCEEDED_ERROR},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+        char *argv2[] = {cases[i].arg, cases[i].value};
+        parser.argc_ = 2;
+        parser.argv_ = argv2;
+        cr_assert_eq(argparse_check_error(argparse_parse_args(&parser)),
+                     cases[i].error);
+        argparse_reset(&parser);
+    }
+    argparse_free(&parser);
+}